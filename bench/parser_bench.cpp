@@ -0,0 +1,1030 @@
+#include <algorithm>
+#include <chrono>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "expression_bytecode.hpp"
+#include "expression_grammar.hpp"
+#include "glr.hpp"
+#include "json_grammar.hpp"
+#include "json_pipeline.hpp"
+#include "json_tree.hpp"
+#include "json_writer.hpp"
+#include "operator_grammar.hpp"
+#include "parser.hpp"
+
+namespace {
+
+struct allocation_counter {
+  size_t count = 0;
+  size_t bytes = 0;
+};
+
+allocation_counter allocations;
+
+} // namespace
+
+void *operator new(size_t size) {
+  ++allocations.count;
+  allocations.bytes += size;
+  if (void *memory = std::malloc(size > 0 ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, size_t) noexcept { std::free(memory); }
+
+namespace {
+
+struct options {
+  size_t documents = 64;
+  size_t document_bytes = 64 * 1024;
+  size_t depth = 64;
+  size_t repetitions = 5;
+  uint64_t seed = 42;
+  std::string_view filter;
+  std::string_view profile;
+};
+
+// Reproducible inputs: the same seed always yields the same corpus.
+class corpus_generator {
+  std::mt19937_64 rng;
+
+  size_t pick(size_t n) { return rng() % n; }
+
+  void number(std::string &out) {
+    char buffer[32];
+    double value = static_cast<double>(static_cast<int64_t>(rng() % 2000000) -
+                                       1000000) /
+                   static_cast<double>(1 + pick(1000));
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+  }
+
+  void text(std::string &out, size_t length) {
+    out += '"';
+    for (size_t i = 0; i < length; ++i) {
+      out += static_cast<char>(i % 6 == 5 ? ' ' : 'a' + pick(26));
+    }
+    out += '"';
+  }
+
+  void scalar(std::string &out) {
+    switch (pick(5)) {
+    case 0:
+      out += "null";
+      break;
+    case 1:
+      out += pick(2) ? "true" : "false";
+      break;
+    case 2:
+    case 3:
+      number(out);
+      break;
+    default:
+      text(out, 4 + pick(12));
+    }
+  }
+
+  // Emits exactly `operands` operands, parenthesized up to `depth` levels.
+  // Products only use 0 and 1 to keep the evaluated `int` from overflowing.
+  // With `variables`, half of the operands are variables from `a` on.
+  void expression(std::string &out, size_t operands, size_t depth,
+                  size_t variables = 0) {
+    for (size_t i = 0; i < operands;) {
+      bool times = i > 0 && pick(4) == 0;
+      if (i > 0) {
+        out += times ? " * " : " + ";
+      }
+      if (!times && depth > 0 && operands - i > 1 && pick(3) == 0) {
+        size_t inner = 1 + pick(std::min<size_t>(operands - i, 8));
+        out += '(';
+        expression(out, inner, depth - 1, variables);
+        out += ')';
+        i += inner;
+      } else if (variables > 0 && pick(2) == 0) {
+        out += static_cast<char>('a' + pick(variables));
+        ++i;
+      } else {
+        out += static_cast<char>('0' + (times ? pick(2) : pick(10)));
+        ++i;
+      }
+    }
+  }
+
+  // Like `expression`, with the operators of all `operators::num_levels`.
+  void operator_expression(std::string &out, size_t operands, size_t depth) {
+    for (size_t i = 0; i < operands;) {
+      if (i > 0) {
+        out += ' ';
+        out += operators::operator_chars[pick(operators::num_levels)];
+        out += ' ';
+      }
+      if (depth > 0 && operands - i > 1 && pick(4) == 0) {
+        size_t inner = 1 + pick(std::min<size_t>(operands - i, 8));
+        out += '(';
+        operator_expression(out, inner, depth - 1);
+        out += ')';
+        i += inner;
+      } else {
+        out += static_cast<char>('0' + pick(10));
+        ++i;
+      }
+    }
+  }
+
+  void nested(std::string &out, size_t depth) {
+    if (depth == 0) {
+      scalar(out);
+    } else if (depth % 2 == 0) {
+      out += R"({"level": )";
+      nested(out, depth - 1);
+      out += ", \"tag\": ";
+      scalar(out);
+      out += '}';
+    } else {
+      out += '[';
+      nested(out, depth - 1);
+      out += ", ";
+      scalar(out);
+      out += ']';
+    }
+  }
+
+public:
+  explicit corpus_generator(uint64_t seed) : rng(seed) {}
+
+  std::string expression(size_t bytes, size_t depth) {
+    std::string out;
+    while (out.size() < bytes) {
+      if (!out.empty()) {
+        out += " + ";
+      }
+      expression(out, 64, depth);
+    }
+    return out;
+  }
+
+  std::string filter_expression(size_t operands, size_t depth,
+                                size_t variables) {
+    std::string out;
+    expression(out, operands, depth, variables);
+    return out;
+  }
+
+  std::vector<int32_t> column(size_t rows) {
+    std::vector<int32_t> values(rows);
+    for (auto &value : values) {
+      value = static_cast<int32_t>(rng() % 2000) - 1000;
+    }
+    return values;
+  }
+
+  std::string nested_expression(size_t bytes, size_t depth) {
+    std::string out;
+    while (out.size() < bytes) {
+      if (!out.empty()) {
+        out += " + ";
+      }
+      out.append(depth, '(');
+      out += '1';
+      for (size_t i = 0; i < depth; ++i) {
+        out += " + 1)";
+      }
+    }
+    return out;
+  }
+
+  std::string operator_expression(size_t bytes, size_t depth) {
+    std::string out;
+    while (out.size() < bytes) {
+      if (!out.empty()) {
+        out += " | ";
+      }
+      operator_expression(out, 64, depth);
+    }
+    return out;
+  }
+
+  std::string wide_object(size_t bytes) {
+    std::string out = "{";
+    for (size_t i = 0; out.size() < bytes; ++i) {
+      out += i == 0 ? "\"key" : ", \"key";
+      out += std::to_string(i);
+      out += "\": ";
+      scalar(out);
+    }
+    return out + '}';
+  }
+
+  std::string deep_nesting(size_t bytes, size_t depth) {
+    std::string out = "[";
+    while (out.size() < bytes) {
+      if (out.size() > 1) {
+        out += ", ";
+      }
+      nested(out, depth);
+    }
+    return out + ']';
+  }
+
+  std::string numeric_array(size_t bytes) {
+    std::string out = "[";
+    while (out.size() < bytes) {
+      if (out.size() > 1) {
+        out += ", ";
+      }
+      number(out);
+    }
+    return out + ']';
+  }
+
+  std::string string_heavy(size_t bytes) {
+    std::string out = "[";
+    while (out.size() < bytes) {
+      if (out.size() > 1) {
+        out += ", ";
+      }
+      out += R"({"name": )";
+      text(out, 16 + pick(48));
+      out += R"(, "body": )";
+      text(out, 64 + pick(256));
+      out += '}';
+    }
+    return out + ']';
+  }
+};
+
+struct event_counter {
+  size_t shifts = 0;
+  size_t reductions = 0;
+  template <typename Token> void shift(Token &&) { ++shifts; }
+  template <typename Rule> void reduce(Rule) { ++reductions; }
+};
+
+struct counts {
+  size_t tokens = 0;
+  size_t reductions = 0;
+};
+
+// Counts tokens and reductions once, untimed. Every mode of a grammar runs
+// the same automaton, so the counts are shared by all of them.
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Lexer, typename End>
+counts count_events(std::vector<std::string> const &documents) {
+  counts total;
+  for (auto &document : documents) {
+    parser::transition_table<Start, Rules, Nonterminals, Terminals,
+                             parser::events<event_counter>>
+        table;
+    Lexer tokens(document);
+    while (tokens.next(
+        [&table](auto &&token) { table.read_token(std::move(token)); })) {
+    }
+    table.read_token(End());
+    table.finish();
+    total.tokens += table.handler.shifts;
+    total.reductions += table.handler.reductions;
+  }
+  return total;
+}
+
+struct checksum_handler {
+  double sum = 0;
+  void on_null() { sum += 1; }
+  void on_bool(bool value) { sum += value; }
+  void on_number(double value) { sum += value; }
+  void on_string(std::string_view value) { sum += value.size(); }
+  void on_key(std::string_view value) { sum += value.size(); }
+  void on_start_object() {}
+  void on_end_object() {}
+  void on_start_list() {}
+  void on_end_list() {}
+};
+
+struct corpus {
+  std::string name;
+  std::vector<std::string> documents;
+  counts events;
+  // JSON paths that the "projection" rows select.
+  std::vector<std::string_view> paths;
+};
+
+struct measurement {
+  double seconds = 0;
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  std::vector<double> latencies;
+};
+
+// Parses every document `repetitions` times after one warm up pass, so the
+// parser's own stacks and arenas are at their steady state size.
+measurement measure(corpus const &input, size_t repetitions,
+                    std::function<bool(std::string_view)> const &parse) {
+  for (auto &document : input.documents) {
+    if (!parse(document)) {
+      std::fprintf(stderr, "%s: document rejected\n", input.name.c_str());
+      std::exit(1);
+    }
+  }
+  measurement result;
+  for (size_t i = 0; i < repetitions; ++i) {
+    for (auto &document : input.documents) {
+      allocation_counter before = allocations;
+      auto start = std::chrono::steady_clock::now();
+      parse(document);
+      auto stop = std::chrono::steady_clock::now();
+      result.allocations += allocations.count - before.count;
+      result.allocated_bytes += allocations.bytes - before.bytes;
+      double seconds = std::chrono::duration<double>(stop - start).count();
+      result.seconds += seconds;
+      result.latencies.push_back(seconds);
+    }
+  }
+  std::sort(result.latencies.begin(), result.latencies.end());
+  return result;
+}
+
+double percentile(std::vector<double> const &sorted, double p) {
+  return sorted[static_cast<size_t>(p * (sorted.size() - 1))];
+}
+
+void report(corpus const &input, char const *mode, size_t repetitions,
+            measurement const &m) {
+  size_t bytes = 0;
+  for (auto &document : input.documents) {
+    bytes += document.size();
+  }
+  double runs = static_cast<double>(repetitions);
+  double docs = runs * input.documents.size();
+  std::printf("%-18s %-18s %9.1f %9.2f %9.2f %10.1f %12.0f %9.1f %9.1f\n",
+              input.name.c_str(), mode, runs * bytes / m.seconds / 1e6,
+              runs * input.events.tokens / m.seconds / 1e6,
+              runs * input.events.reductions / m.seconds / 1e6,
+              m.allocations / docs, m.allocated_bytes / docs,
+              percentile(m.latencies, 0.5) * 1e6,
+              percentile(m.latencies, 0.99) * 1e6);
+}
+
+bool selected(options const &opts, std::string const &name) {
+  return opts.filter.empty() || name.find(opts.filter) != std::string::npos;
+}
+
+// Parses and evaluates a document with a GLR table, to compare it with the
+// LR tables on a grammar without conflicts.
+template <typename Table, typename Lexer, typename End>
+bool glr_parse(Table &table, std::string_view doc) {
+  table.reset();
+  try {
+    Lexer tokens(doc);
+    while (tokens.next([&table](auto &&token) {
+      table.read_token(std::move(token));
+    })) {
+    }
+    table.read_token(End());
+    if (!table.finish()) {
+      return false;
+    }
+    table.evaluate();
+  } catch (std::exception const &) {
+    return false;
+  }
+  return true;
+}
+
+void run_expressions(options const &opts, corpus_generator &generate) {
+  std::vector<corpus> corpora(2);
+  corpora[0].name = "expr_mixed";
+  corpora[1].name = "expr_nested";
+  for (size_t i = 0; i < opts.documents; ++i) {
+    corpora[0].documents.push_back(
+        generate.expression(opts.document_bytes, opts.depth));
+    corpora[1].documents.push_back(
+        generate.nested_expression(opts.document_bytes, opts.depth));
+  }
+
+  expression::scanner values;
+  parser::glr_table<expression::S, expression::rules,
+                    expression::nonterminals, expression::terminals>
+      glr;
+  for (auto &input : corpora) {
+    if (!selected(opts, input.name)) {
+      continue;
+    }
+    input.events =
+        count_events<expression::S, expression::rules, expression::nonterminals,
+                     expression::terminals, expression::lexer,
+                     expression::end>(input.documents);
+    report(input, "variant values", opts.repetitions,
+           measure(input, opts.repetitions, [&values](std::string_view doc) {
+             return values.parse(doc).has_value();
+           }));
+    report(input, "glr forest", opts.repetitions,
+           measure(input, opts.repetitions, [&glr](std::string_view doc) {
+             return glr_parse<decltype(glr), expression::lexer,
+                              expression::end>(glr, doc);
+           }));
+  }
+}
+
+// Evaluates a filter expression over `rows` rows of 8 variables: compiled
+// again for every row, compiled once and interpreted row by row, and compiled
+// once and evaluated column at a time. Exits if the results differ. The rows
+// have their own generator, so the other corpora stay the same.
+void run_bytecode(options const &opts) {
+  if (!selected(opts, "expr_rows")) {
+    return;
+  }
+  corpus_generator generate(opts.seed);
+  constexpr size_t num_variables = 8;
+  size_t const rows = opts.documents * opts.document_bytes / 16;
+  std::string filter = generate.filter_expression(64, 4, num_variables);
+  std::vector<std::vector<int32_t>> columns;
+  std::vector<int32_t const *> column_data;
+  for (size_t k = 0; k < num_variables; ++k) {
+    columns.push_back(generate.column(rows));
+    column_data.push_back(columns.back().data());
+  }
+  std::vector<int32_t> by_rows(rows * num_variables);
+  for (size_t r = 0; r < rows; ++r) {
+    for (size_t k = 0; k < num_variables; ++k) {
+      by_rows[r * num_variables + k] = columns[k][r];
+    }
+  }
+
+  expression::bytecode::compiler compiler;
+  expression::bytecode::evaluator evaluator;
+  expression::bytecode::program program = *compiler.compile(filter);
+  std::vector<int32_t> expected(rows);
+  std::vector<int32_t> out(rows);
+  auto time = [&opts](auto &&run) {
+    run();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < opts.repetitions; ++i) {
+      run();
+    }
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(stop - start).count() /
+           static_cast<double>(opts.repetitions);
+  };
+  auto print = [](char const *mode, size_t count, double seconds) {
+    std::printf("%-18s %-18s %9.1f Mrows/s %9.2f ns/row\n", "expr_rows",
+                mode, count / seconds / 1e6, seconds / count * 1e9);
+  };
+
+  size_t const recompiled = rows / 256;
+  print("compile per row", recompiled, time([&] {
+          for (size_t r = 0; r < recompiled; ++r) {
+            auto row_program = compiler.compile(filter);
+            expected[r] = evaluator.evaluate(*row_program,
+                                             &by_rows[r * num_variables]);
+          }
+        }));
+  print("bytecode rows", rows, time([&] {
+          for (size_t r = 0; r < rows; ++r) {
+            expected[r] =
+                evaluator.evaluate(program, &by_rows[r * num_variables]);
+          }
+        }));
+  print("bytecode columns", rows,
+        time([&] { evaluator.evaluate(program, column_data, out); }));
+  if (out != expected) {
+    std::fprintf(stderr, "expr_rows: column results differ\n");
+    std::exit(1);
+  }
+}
+
+// Compares a grammar with one nonterminal per operator level, which needs the
+// GLR parser, with one nonterminal and precedence declarations. The counted
+// reductions are those of the precedence grammar.
+void run_operators(options const &opts, corpus_generator &generate) {
+  corpus input;
+  input.name = "ops10";
+  if (!selected(opts, input.name)) {
+    return;
+  }
+  for (size_t i = 0; i < opts.documents; ++i) {
+    input.documents.push_back(
+        generate.operator_expression(opts.document_bytes, opts.depth));
+  }
+  input.events =
+      count_events<operators::precedence_start,
+                   decltype(operators::make_precedence_rules(
+                       operators::levels())),
+                   parser::set<operators::precedence_start, operators::P>,
+                   operators::terminals, operators::lexer, operators::end>(
+          input.documents);
+
+  operators::layered_table layered;
+  report(input, "layered glr", opts.repetitions,
+         measure(input, opts.repetitions, [&layered](std::string_view doc) {
+           return glr_parse<operators::layered_table, operators::lexer,
+                            operators::end>(layered, doc);
+         }));
+  operators::precedence_table precedence;
+  report(input, "precedence lr", opts.repetitions,
+         measure(input, opts.repetitions, [&precedence](std::string_view doc) {
+           precedence.reset();
+           try {
+             operators::lexer tokens(doc);
+             while (tokens.next([&precedence](auto &&token) {
+               precedence.read_token(std::move(token));
+             })) {
+             }
+             precedence.read_token(operators::end());
+             precedence.get_parse_result();
+           } catch (std::exception const &) {
+             return false;
+           }
+           return true;
+         }));
+}
+
+// Records the table lookups of the JSON grammar on `corpora` and writes them
+// as the header `json_profile.hpp` for `parser::profile_guided`.
+void write_json_profile(std::vector<corpus> const &corpora,
+                        std::string_view path) {
+  using counted =
+      parser::transition_table<json::S, json::rules, json::nonterminals,
+                               json::terminals, parser::recognize,
+                               parser::instrumentation, json::layout>;
+  counted table;
+  for (auto &input : corpora) {
+    for (auto &document : input.documents) {
+      table.reset();
+      json::lexer tokens(document);
+      while (tokens.next<false>(
+          [&table](auto token) { table.read_token(token); })) {
+      }
+      table.read_token(parser::kind<json::end>());
+    }
+  }
+  std::ofstream out{std::string(path)};
+  out << "// Generated by `parser_bench --write-profile`: table lookups of the "
+         "JSON\n// grammar on the benchmark corpora, see "
+         "`parser::profile_guided`.\n"
+         "#if !defined(JSON_PROFILE_HPP)\n#define JSON_PROFILE_HPP\n\n"
+         "#include <array>\n#include <cstdint>\n\nnamespace json {\n\n";
+  counted::statistics().write_profile(out, "profile");
+  out << "\n} // namespace json\n\n#endif\n";
+}
+
+// Parses wide objects and looks up every member by name, through
+// `json_object::find` and by scanning the members for the interned key.
+void run_member_lookups(corpus const &input, size_t repetitions) {
+  json::scanner dom;
+  std::vector<std::string> names;
+  auto find_all = [&dom, &names](std::string_view doc, auto &&find) {
+    auto value = dom.parse(doc);
+    auto object = dynamic_cast<json::json_object const *>(value.get());
+    if (!object) {
+      return false;
+    }
+    while (names.size() < object->members.size()) {
+      names.push_back("key" + std::to_string(names.size()));
+    }
+    for (size_t i = 0; i < object->members.size(); ++i) {
+      if (!find(*object, names[i])) {
+        return false;
+      }
+    }
+    return true;
+  };
+  report(input, "dom find all", repetitions,
+         measure(input, repetitions, [&find_all](std::string_view doc) {
+           return find_all(doc, [](json::json_object const &object,
+                                   std::string const &name) {
+             return object.find(name) != nullptr;
+           });
+         }));
+  report(input, "dom scan all", repetitions,
+         measure(input, repetitions, [&find_all](std::string_view doc) {
+           return find_all(doc, [](json::json_object const &object,
+                                   std::string const &name) {
+             uint32_t key = json::member_names::find(name);
+             for (auto &member : object.members) {
+               if (member.key == key) {
+                 return true;
+               }
+             }
+             return false;
+           });
+         }));
+}
+
+// A document with every kind of escape sequence, and how the writer writes
+// it after the lexer decoded it.
+constexpr std::string_view escaped_document =
+    R"(["a\nb", "q\"\\\/", "\u00e9\ud83d\ude00\t", {"k\u0022": "\b\f\r"}])";
+constexpr std::string_view escaped_written =
+    R"(["a\nb","q\"\\/",")"
+    "\xc3\xa9\xf0\x9f\x98\x80"
+    R"(\t",{"k\"":"\b\f\r"}])";
+
+// Writes parsed documents compactly and pretty printed, and parses each
+// document, writes it and parses the output again. Exits if writing a
+// document parsed from the writer's output does not reproduce that output,
+// or if `escaped_document` is not written as `escaped_written`.
+void run_serialization(corpus const &input, size_t repetitions) {
+  json::scanner dom;
+  json::writer out;
+  auto round_trip = [&](json::json_value const &value) {
+    std::string compact(out.write(value));
+    for (auto format : {json::style::compact, json::style::pretty}) {
+      auto again = dom.parse(out.write(value, format));
+      if (!again || out.write(*again) != compact) {
+        std::fprintf(stderr, "%s: round trip differs\n", input.name.c_str());
+        std::exit(1);
+      }
+    }
+  };
+  auto escaped = dom.parse(escaped_document);
+  if (!escaped || out.write(*escaped) != escaped_written) {
+    std::fprintf(stderr, "escape sequences are not written back unchanged\n");
+    std::exit(1);
+  }
+  round_trip(*escaped);
+  std::unordered_map<char const *, std::unique_ptr<json::json_value>> parsed;
+  for (auto &document : input.documents) {
+    auto &value = parsed[document.data()] = dom.parse(document);
+    round_trip(*value);
+  }
+  for (auto format : {json::style::compact, json::style::pretty}) {
+    report(input,
+           format == json::style::compact ? "write compact" : "write pretty",
+           repetitions,
+           measure(input, repetitions,
+                   [&out, &parsed, format](std::string_view doc) {
+                     return !out.write(*parsed[doc.data()], format).empty();
+                   }));
+  }
+  json::scanner reparse;
+  report(input, "round trip", repetitions,
+         measure(input, repetitions,
+                 [&dom, &reparse, &out](std::string_view doc) {
+                   auto value = dom.parse(doc);
+                   return value && reparse.parse(out.write(*value));
+                 }));
+}
+
+// Parses every document from a temporary file, once read completely before
+// a monolithic parse and once through the reader, tokenizer and table stages
+// of `json::pipeline_scanner` on one thread and on a thread per stage.
+void run_pipeline(corpus const &input, size_t repetitions) {
+  std::unordered_map<char const *, std::FILE *> files;
+  for (auto &document : input.documents) {
+    std::FILE *file = std::tmpfile();
+    if (!file ||
+        std::fwrite(document.data(), 1, document.size(), file) !=
+            document.size() ||
+        std::fflush(file) != 0) {
+      std::fprintf(stderr, "%s: cannot write temporary file\n",
+                   input.name.c_str());
+      std::exit(1);
+    }
+    files[document.data()] = file;
+  }
+  auto rewound = [&files](std::string_view doc) {
+    int fd = fileno(files[doc.data()]);
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+  };
+  json::scanner dom;
+  std::string text;
+  report(input, "read + dom", repetitions,
+         measure(input, repetitions, [&](std::string_view doc) {
+           int fd = rewound(doc);
+           text.resize(doc.size() + 1);
+           size_t size = 0;
+           ssize_t n = 0;
+           while ((n = read(fd, text.data() + size, text.size() - size)) > 0) {
+             size += static_cast<size_t>(n);
+           }
+           if (n < 0) {
+             return false;
+           }
+           return dom.parse(std::string_view(text.data(), size)) != nullptr;
+         }));
+  json::pipeline_scanner pipeline;
+  for (auto where :
+       {parser::placement::one_thread, parser::placement::thread_per_stage}) {
+    report(input,
+           where == parser::placement::one_thread ? "pipeline 1 thread"
+                                                  : "pipeline 3 threads",
+           repetitions,
+           measure(input, repetitions, [&](std::string_view doc) {
+             return pipeline.parse(rewound(doc), where) != nullptr;
+           }));
+  }
+  for (auto &[document, file] : files) {
+    std::fclose(file);
+  }
+}
+
+void run_json(options const &opts, corpus_generator &generate) {
+  std::vector<corpus> corpora(4);
+  corpora[0].name = "json_wide_object";
+  corpora[1].name = "json_deep_nesting";
+  corpora[2].name = "json_numeric_array";
+  corpora[3].name = "json_string_heavy";
+  corpora[0].paths = {"key0", "key100", "id"};
+  corpora[1].paths = {"[0].tag", "[1].level[1]", "[3].level[0].level[0].tag"};
+  corpora[2].paths = {"[0]", "[100]", "[1000]"};
+  corpora[3].paths = {"[0].name", "[10].body", "[100].name"};
+  for (size_t i = 0; i < opts.documents; ++i) {
+    corpora[0].documents.push_back(generate.wide_object(opts.document_bytes));
+    corpora[1].documents.push_back(
+        generate.deep_nesting(opts.document_bytes, opts.depth));
+    corpora[2].documents.push_back(generate.numeric_array(opts.document_bytes));
+    corpora[3].documents.push_back(generate.string_heavy(opts.document_bytes));
+  }
+
+  if (!opts.profile.empty()) {
+    write_json_profile(corpora, opts.profile);
+  }
+
+  json::scanner dom;
+  json::tree::scanner tree;
+  json::sax_scanner<checksum_handler> sax;
+  json::validator recognizer;
+  json::profiled_validator profiled;
+  for (auto &input : corpora) {
+    if (!selected(opts, input.name)) {
+      continue;
+    }
+    input.events =
+        count_events<json::S, json::rules, json::nonterminals, json::terminals,
+                     json::lexer, json::end>(input.documents);
+    report(input, "symbol* dom", opts.repetitions,
+           measure(input, opts.repetitions, [&dom](std::string_view doc) {
+             return dom.parse(doc) != nullptr;
+           }));
+    report(input, "variant tree", opts.repetitions,
+           measure(input, opts.repetitions, [&tree](std::string_view doc) {
+             return tree.parse(doc).has_value();
+           }));
+    report(input, "sax events", opts.repetitions,
+           measure(input, opts.repetitions,
+                   [&sax](std::string_view doc) { return sax.parse(doc); }));
+    report(input, "recognizer", opts.repetitions,
+           measure(input, opts.repetitions,
+                   [&recognizer](std::string_view doc) {
+                     return recognizer.validate(doc) == std::string_view::npos;
+                   }));
+    report(input, "recognizer pgo", opts.repetitions,
+           measure(input, opts.repetitions, [&profiled](std::string_view doc) {
+             return profiled.validate(doc) == std::string_view::npos;
+           }));
+    json::projecting_scanner projection(input.paths);
+    report(input, "projection", opts.repetitions,
+           measure(input, opts.repetitions,
+                   [&projection](std::string_view doc) {
+                     projection.parse(doc);
+                     return projection.error_offset() ==
+                            std::string_view::npos;
+                   }));
+    run_serialization(input, opts.repetitions);
+    run_pipeline(input, opts.repetitions);
+  }
+  if (selected(opts, corpora[0].name)) {
+    run_member_lookups(corpora[0], opts.repetitions);
+  }
+}
+
+// The allocations of parsing one document when the budget was recorded. A
+// parse may exceed them by a quarter, which absorbs changes to the growth of
+// standard containers but not a value that allocates twice. Zero budgets are
+// exact.
+struct allocation_budget {
+  size_t count = 0;
+  size_t bytes = 0;
+
+  static constexpr size_t limit(size_t recorded) noexcept {
+    return recorded + recorded / 4;
+  }
+
+  constexpr bool admits(allocation_counter const &used) const noexcept {
+    return used.count <= limit(count) && used.bytes <= limit(bytes);
+  }
+};
+
+allocation_counter since(allocation_counter const &before) {
+  return {allocations.count - before.count, allocations.bytes - before.bytes};
+}
+
+// Parses `document` with a new `Parser`, including its construction, and
+// then again with the same parser. Prints the allocations of both parses and
+// returns whether `fresh` and `reused` admit them.
+template <typename Parser, typename Parse>
+bool check_budget(char const *name, char const *mode,
+                  std::string const &document, allocation_budget fresh,
+                  allocation_budget reused, Parse &&parse) {
+  bool accepted = false;
+  allocation_counter first;
+  allocation_counter second;
+  {
+    allocation_counter before = allocations;
+    Parser parser;
+    accepted = parse(parser, document);
+    first = since(before);
+    before = allocations;
+    accepted = parse(parser, document) && accepted;
+    second = since(before);
+  }
+  bool ok = accepted && fresh.admits(first) && reused.admits(second);
+  std::printf("%-18s %-12s %8zu %10zu %8zu %10zu  %s\n", name, mode,
+              first.count, first.bytes, second.count, second.bytes,
+              ok ? "ok" : (accepted ? "over budget" : "rejected"));
+  return ok;
+}
+
+// Checks the allocations of both example grammars, in variant and `symbol*`
+// mode and without values, on fixed documents. A reused parser that builds
+// no values must not allocate at all, so changes to the value stacks or
+// symbol constructors that add allocations fail here. The first parse of new
+// JSON member names includes interning them. After a change that allocates
+// differently on purpose, record the numbers this prints as the new budgets.
+// Returns the exit code.
+int check_budgets() {
+  corpus_generator generate(42);
+  struct json_case {
+    char const *name;
+    std::string document;
+    allocation_budget dom_fresh;
+    allocation_budget dom_reused;
+    allocation_budget tree_fresh;
+    allocation_budget tree_reused;
+    allocation_budget fresh;
+  };
+  std::vector<json_case> json_cases = {
+      {"json_single",
+       R"({"id": 1, "tags": ["a", "b"], "nested": {"ok": true, "n": null}})",
+       {47, 71744},
+       {15, 704},
+       {17, 2912},
+       {7, 680},
+       {5, 248}},
+      {"json_deep",
+       generate.deep_nesting(2, 1024),
+       {4153, 871992},
+       {4099, 150256},
+       {2075, 737248},
+       {2049, 147496},
+       {13, 65528}},
+      {"json_wide_array",
+       generate.numeric_array(64 * 1024),
+       {3432, 764192},
+       {3401, 173960},
+       {20, 328208},
+       {13, 327640},
+       {4, 120}},
+      {"json_wide_object",
+       generate.wide_object(64 * 1024),
+       {2899, 2778816},
+       {2809, 360608},
+       {21, 459776},
+       {13, 458696},
+       {4, 120}},
+  };
+  std::string expression_single = generate.expression(4 * 1024, 8);
+  std::string expression_deep = generate.nested_expression(1, 1024);
+
+  std::printf("%-18s %-12s %8s %10s %8s %10s\n", "document", "mode",
+              "allocs", "bytes", "reused", "bytes");
+  bool ok = true;
+  auto variant_values = [](expression::scanner &scanner,
+                           std::string const &document) {
+    return scanner.parse(document).has_value();
+  };
+  ok &= check_budget<expression::scanner>("expr_single", "variant",
+                                          expression_single, {10, 496}, {0, 0},
+                                          variant_values);
+  ok &= check_budget<expression::scanner>("expr_deep", "variant",
+                                          expression_deep, {24, 65520}, {0, 0},
+                                          variant_values);
+  for (auto &c : json_cases) {
+    ok &= check_budget<json::scanner>(
+        c.name, "symbol* dom", c.document, c.dom_fresh, c.dom_reused,
+        [](json::scanner &dom, std::string const &document) {
+          return dom.parse(document) != nullptr;
+        });
+    ok &= check_budget<json::tree::scanner>(
+        c.name, "variant tree", c.document, c.tree_fresh, c.tree_reused,
+        [](json::tree::scanner &tree, std::string const &document) {
+          return tree.parse(document).has_value();
+        });
+    ok &= check_budget<json::sax_scanner<checksum_handler>>(
+        c.name, "sax events", c.document, c.fresh, {0, 0},
+        [](json::sax_scanner<checksum_handler> &sax,
+           std::string const &document) { return sax.parse(document); });
+    ok &= check_budget<json::validator>(
+        c.name, "recognizer", c.document, c.fresh, {0, 0},
+        [](json::validator &recognizer, std::string const &document) {
+          return recognizer.validate(document) == std::string_view::npos;
+        });
+  }
+  return ok ? 0 : 1;
+}
+
+// Parses an invalid document with instrumented validators in discovery and
+// profile guided order. Statistics number states by discovery order, so both
+// have to count the error in the same state. Returns the exit code.
+int check_error_states() {
+  using discovery =
+      parser::transition_table<json::S, json::rules, json::nonterminals,
+                               json::terminals, parser::recognize,
+                               parser::instrumentation, json::layout>;
+  using profiled = parser::transition_table<
+      json::S, json::rules, json::nonterminals, json::terminals,
+      parser::recognize, parser::instrumentation,
+      parser::profile_guided<json::profile>>;
+  // Both tables count into the same statistics, so each returns the errors
+  // its parse added.
+  auto errors = [](auto table) {
+    auto before = decltype(table)::statistics().errors;
+    json::lexer tokens(R"({"id": [1, 2 3]})");
+    try {
+      while (tokens.next<false>(
+          [&table](auto token) { table.read_token(token); })) {
+      }
+      table.read_token(parser::kind<json::end>());
+    } catch (std::exception const &) {
+    }
+    auto after = decltype(table)::statistics().errors;
+    for (size_t i = 0; i < after.size(); ++i) {
+      after[i] -= before[i];
+    }
+    return after;
+  };
+  auto expected = errors(discovery());
+  bool ok = std::count(expected.begin(), expected.end(), 1) == 1 &&
+            errors(profiled()) == expected;
+  std::printf("%-18s %-12s %s\n", "json_error_state", "profiled",
+              ok ? "ok" : "wrong state");
+  return ok ? 0 : 1;
+}
+
+size_t parse_size(char const *value) {
+  size_t result = 0;
+  std::from_chars(value, value + std::strlen(value), result);
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc == 2 && std::string_view(argv[1]) == "--check-budgets") {
+    int budgets = check_budgets();
+    return check_error_states() == 0 ? budgets : 1;
+  }
+  options opts;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string_view flag = argv[i];
+    if (flag == "--documents") {
+      opts.documents = std::max<size_t>(parse_size(argv[i + 1]), 1);
+    } else if (flag == "--document-bytes") {
+      opts.document_bytes = parse_size(argv[i + 1]);
+    } else if (flag == "--depth") {
+      opts.depth = parse_size(argv[i + 1]);
+    } else if (flag == "--repetitions") {
+      opts.repetitions = std::max<size_t>(parse_size(argv[i + 1]), 1);
+    } else if (flag == "--seed") {
+      opts.seed = parse_size(argv[i + 1]);
+    } else if (flag == "--filter") {
+      opts.filter = argv[i + 1];
+    } else if (flag == "--write-profile") {
+      opts.profile = argv[i + 1];
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [--documents N] [--document-bytes N] "
+                   "[--depth N] [--repetitions N] [--seed N] "
+                   "[--filter corpus] [--write-profile header]\n"
+                   "       %s --check-budgets\n",
+                   argv[0], argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("%-18s %-18s %9s %9s %9s %10s %12s %9s %9s\n", "corpus", "mode",
+              "MB/s", "Mtok/s", "Mred/s", "allocs/doc", "bytes/doc",
+              "p50 us", "p99 us");
+  corpus_generator generate(opts.seed);
+  run_expressions(opts, generate);
+  run_bytecode(opts);
+  run_operators(opts, generate);
+  run_json(opts, generate);
+  return 0;
+}
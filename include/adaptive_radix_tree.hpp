@@ -6,18 +6,26 @@
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace parser {
 
 constexpr uint8_t empty_key = std::numeric_limits<uint8_t>::max();
 constexpr size_t empty_slot = std::numeric_limits<size_t>::max();
 
+// Nodes with up to 4, 16, 48 and 256 children. `find` returns the index of
+// the child that follows `c`, or `empty_slot`. The 48 and 256 slot nodes
+// mark free entries with `empty_key` and `empty_slot`.
 struct node_256 {
   constexpr static size_t num_slots = 256;
   std::array<size_t, num_slots> follow_idxs;
   constexpr void insert_next(char c, size_t follow_idx) {
-    follow_idxs[c] = follow_idx;
+    follow_idxs[static_cast<uint8_t>(c)] = follow_idx;
+  }
+  constexpr size_t find(char c) const noexcept {
+    return follow_idxs[static_cast<uint8_t>(c)];
   }
 };
 
@@ -28,9 +36,13 @@ struct node_48 {
   std::array<uint8_t, num_keys> keys;
   std::array<size_t, num_slots> follow_idxs;
   constexpr void insert_next(char c, size_t follow_idx) noexcept {
-    keys[c] = static_cast<uint8_t>(filled);
+    keys[static_cast<uint8_t>(c)] = static_cast<uint8_t>(filled);
     follow_idxs[filled++] = follow_idx;
   }
+  constexpr size_t find(char c) const noexcept {
+    uint8_t slot = keys[static_cast<uint8_t>(c)];
+    return slot == empty_key ? empty_slot : follow_idxs[slot];
+  }
 };
 
 struct node_16 {
@@ -42,6 +54,14 @@ struct node_16 {
     keys[filled] = c;
     follow_idxs[filled++] = follow_idx;
   }
+  constexpr size_t find(char c) const noexcept {
+    for (size_t i = 0; i < filled; ++i) {
+      if (keys[i] == c) {
+        return follow_idxs[i];
+      }
+    }
+    return empty_slot;
+  }
 };
 
 struct node_4 {
@@ -53,6 +73,14 @@ struct node_4 {
     keys[filled] = c;
     follow_idxs[filled++] = follow_idx;
   }
+  constexpr size_t find(char c) const noexcept {
+    for (size_t i = 0; i < filled; ++i) {
+      if (keys[i] == c) {
+        return follow_idxs[i];
+      }
+    }
+    return empty_slot;
+  }
 };
 
 struct NodesCount {
@@ -373,6 +401,194 @@ private:
   }
 };
 
+// Adaptive radix tree that grows at run time and maps strings to values.
+// Every node starts without children, gets a 4 slot node on its first child
+// and grows into 16, 48 and 256 slot nodes as it fills up. A node keeps the
+// bytes below it up to the next branch or key end as its prefix, so a chain
+// of single children is one node.
+class growing_radix_tree {
+  enum class kind : uint8_t { leaf, n4, n16, n48, n256 };
+
+  struct header {
+    std::string prefix;
+    size_t value = empty_slot;
+    kind type = kind::leaf;
+    size_t slot = 0;
+  };
+
+  std::vector<header> nodes{header{}};
+  // Outgrown nodes stay in their pools, a node grows at most three times.
+  std::vector<node_4> node_4s;
+  std::vector<node_16> node_16s;
+  std::vector<node_48> node_48s;
+  std::vector<node_256> node_256s;
+  size_t num_keys = 0;
+
+  size_t child(header const &node, char c) const noexcept {
+    switch (node.type) {
+    case kind::n4:
+      return node_4s[node.slot].find(c);
+    case kind::n16:
+      return node_16s[node.slot].find(c);
+    case kind::n48:
+      return node_48s[node.slot].find(c);
+    case kind::n256:
+      return node_256s[node.slot].find(c);
+    default:
+      return empty_slot;
+    }
+  }
+
+  // Moves the children of a full node into the next larger node type.
+  void grow(header &node) {
+    switch (node.type) {
+    case kind::leaf:
+      node.slot = node_4s.size();
+      node_4s.emplace_back();
+      node.type = kind::n4;
+      break;
+    case kind::n4: {
+      node_4 const &full = node_4s[node.slot];
+      if (full.filled < node_4::num_slots) {
+        break;
+      }
+      node_16 grown{};
+      for (size_t i = 0; i < full.filled; ++i) {
+        grown.insert_next(full.keys[i], full.follow_idxs[i]);
+      }
+      node.slot = node_16s.size();
+      node_16s.push_back(grown);
+      node.type = kind::n16;
+      break;
+    }
+    case kind::n16: {
+      node_16 const &full = node_16s[node.slot];
+      if (full.filled < node_16::num_slots) {
+        break;
+      }
+      node_48 grown{};
+      grown.keys.fill(empty_key);
+      for (size_t i = 0; i < full.filled; ++i) {
+        grown.insert_next(full.keys[i], full.follow_idxs[i]);
+      }
+      node.slot = node_48s.size();
+      node_48s.push_back(grown);
+      node.type = kind::n48;
+      break;
+    }
+    case kind::n48: {
+      node_48 const &full = node_48s[node.slot];
+      if (full.filled < node_48::num_slots) {
+        break;
+      }
+      node_256 grown{};
+      grown.follow_idxs.fill(empty_slot);
+      for (size_t c = 0; c < node_48::num_keys; ++c) {
+        if (full.keys[c] != empty_key) {
+          grown.follow_idxs[c] = full.follow_idxs[full.keys[c]];
+        }
+      }
+      node.slot = node_256s.size();
+      node_256s.push_back(grown);
+      node.type = kind::n256;
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  void add_child(size_t idx, char c, size_t follow_idx) {
+    header &node = nodes[idx];
+    grow(node);
+    switch (node.type) {
+    case kind::n4:
+      node_4s[node.slot].insert_next(c, follow_idx);
+      break;
+    case kind::n16:
+      node_16s[node.slot].insert_next(c, follow_idx);
+      break;
+    case kind::n48:
+      node_48s[node.slot].insert_next(c, follow_idx);
+      break;
+    default:
+      node_256s[node.slot].insert_next(c, follow_idx);
+    }
+  }
+
+  // Splits the prefix of a node after `length` bytes. The node keeps the
+  // first part and gets a single child with the rest, its value and its
+  // children, so references to the node stay valid.
+  void split(size_t idx, size_t length) {
+    header &node = nodes[idx];
+    char c = node.prefix[length];
+    header rest{node.prefix.substr(length + 1), node.value, node.type,
+                node.slot};
+    node.prefix.resize(length);
+    node.value = empty_slot;
+    node.type = kind::leaf;
+    nodes.push_back(std::move(rest));
+    add_child(idx, c, nodes.size() - 1);
+  }
+
+public:
+  // Value of `key`, or `empty_slot`.
+  size_t find(std::string_view key) const noexcept {
+    size_t idx = 0;
+    while (true) {
+      header const &node = nodes[idx];
+      if (key.substr(0, node.prefix.size()) != node.prefix) {
+        return empty_slot;
+      }
+      key.remove_prefix(node.prefix.size());
+      if (key.empty()) {
+        return node.value;
+      }
+      idx = child(node, key[0]);
+      if (idx == empty_slot) {
+        return empty_slot;
+      }
+      key.remove_prefix(1);
+    }
+  }
+
+  // Inserts `key` with `value` unless it is present, and returns the value
+  // stored for `key`.
+  size_t insert(std::string_view key, size_t value) {
+    size_t idx = 0;
+    while (true) {
+      std::string_view prefix = nodes[idx].prefix;
+      size_t common = 0;
+      while (common < prefix.size() && common < key.size() &&
+             prefix[common] == key[common]) {
+        ++common;
+      }
+      if (common < prefix.size()) {
+        split(idx, common);
+      }
+      key.remove_prefix(common);
+      if (key.empty()) {
+        if (nodes[idx].value == empty_slot) {
+          nodes[idx].value = value;
+          ++num_keys;
+        }
+        return nodes[idx].value;
+      }
+      size_t next = child(nodes[idx], key[0]);
+      if (next == empty_slot) {
+        nodes.push_back(header{std::string(key.substr(1)), value});
+        add_child(idx, key[0], nodes.size() - 1);
+        ++num_keys;
+        return value;
+      }
+      idx = next;
+      key.remove_prefix(1);
+    }
+  }
+
+  size_t size() const noexcept { return num_keys; }
+};
+
 } // namespace parser
 
 #endif
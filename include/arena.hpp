@@ -0,0 +1,88 @@
+#if !defined(ARENA_HPP)
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace parser {
+
+struct symbol {
+  virtual ~symbol() {}
+};
+
+// Bump allocator for the symbols of one parse in `symbol *` mode. All symbols
+// are destroyed and the memory is rewound on `reset`, but the blocks are kept,
+// so a reused arena does not allocate once it has grown to the document size.
+class symbol_arena {
+  constexpr static size_t block_size = 64 * 1024;
+
+  struct block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size;
+  };
+
+  std::vector<block> blocks;
+  std::vector<symbol *> live;
+  size_t current = 0;
+  size_t offset = 0;
+
+  void *allocate(size_t size, size_t alignment) {
+    while (current < blocks.size()) {
+      size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+      if (aligned + size <= blocks[current].size) {
+        offset = aligned + size;
+        return blocks[current].data.get() + aligned;
+      }
+      ++current;
+      offset = 0;
+    }
+    size_t new_size = size + alignment > block_size ? size + alignment
+                                                    : block_size;
+    blocks.push_back({std::make_unique<std::byte[]>(new_size), new_size});
+    return allocate(size, alignment);
+  }
+
+public:
+  symbol_arena() = default;
+  symbol_arena(symbol_arena const &) = delete;
+  symbol_arena &operator=(symbol_arena const &) = delete;
+  symbol_arena(symbol_arena &&) = default;
+  symbol_arena &operator=(symbol_arena &&) = default;
+  ~symbol_arena() { reset(); }
+
+  template <typename T, typename... Args> T *make(Args &&... args) {
+    T *object = new (allocate(sizeof(T), alignof(T)))
+        T{std::forward<Args>(args)...};
+    live.push_back(object);
+    return object;
+  }
+
+  void reset() noexcept {
+    for (auto it = live.rbegin(); it != live.rend(); ++it) {
+      (*it)->~symbol();
+    }
+    live.clear();
+    current = 0;
+    offset = 0;
+  }
+
+  size_t capacity() const noexcept {
+    size_t bytes = 0;
+    for (auto &b : blocks) {
+      bytes += b.size;
+    }
+    return bytes;
+  }
+};
+
+// Placeholder arena for `std::variant` mode, where symbols live by value.
+struct no_arena {
+  constexpr void reset() noexcept {}
+};
+
+} // namespace parser
+
+#endif
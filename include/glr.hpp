@@ -0,0 +1,599 @@
+#if !defined(GLR_HPP)
+#define GLR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace parser {
+
+// Shifts of every state, also of those that reduce, which the LR(0) rows
+// resolve in favour of the reduction.
+template <typename... State, typename... States, typename... Rules,
+          typename... Nonterminals, typename... Terminals>
+constexpr transition_table_row<Terminals...>
+init_shift_row(set<State...> state, set<States...> states, set<Rules...> rules,
+               set<Nonterminals...> nonterminals, set<Terminals...>) noexcept {
+  return {init_shift(state, states, rules, nonterminals, set<Terminals>())...};
+}
+
+template <typename... States, typename... Rules, typename... Nonterminals,
+          typename... Terminals>
+constexpr std::array<transition_table_row<Terminals...>, sizeof...(States)>
+init_shift_rows(set<States...> states, set<Rules...> rules,
+                set<Nonterminals...> nonterminals,
+                set<Terminals...> terminals) noexcept {
+  return {init_shift_row(States(), states, rules, nonterminals, terminals)...};
+}
+
+template <typename... States>
+constexpr size_t count_reductions(set<States...>) noexcept {
+  return (num_reduces(States()) + ... + 0);
+}
+
+// Index of each state's first reduction in `collect_reductions`.
+template <typename... States>
+constexpr std::array<size_t, sizeof...(States) + 1>
+reduction_offsets(set<States...>) noexcept {
+  std::array<size_t, sizeof...(States) + 1> offsets{};
+  size_t state = 0;
+  ((offsets[state + 1] = offsets[state] + num_reduces(States()), ++state),
+   ...);
+  return offsets;
+}
+
+template <size_t NumReductions, typename Lhs, typename... Seen,
+          typename... Rhs, typename... Rules>
+constexpr void add_reduction(bullet_rule<Lhs, set<Seen...>, Rhs...>,
+                             set<Rules...>,
+                             std::array<size_t, NumReductions> &reductions,
+                             size_t &num) noexcept {
+  if constexpr (sizeof...(Rhs) == 0) {
+    reductions[num++] = idx_of<0, bullet_rule<Lhs, set<>, Seen...>, Rules...>();
+  }
+}
+
+template <size_t NumReductions, typename... Items, typename Rules>
+constexpr void add_reductions(set<Items...>, Rules rules,
+                              std::array<size_t, NumReductions> &reductions,
+                              size_t &num) noexcept {
+  (add_reduction(Items(), rules, reductions, num), ...);
+}
+
+// The rules that every state reduces, by state.
+template <size_t NumReductions, typename... States, typename Rules>
+constexpr std::array<size_t, NumReductions>
+collect_reductions(set<States...>, Rules rules) noexcept {
+  std::array<size_t, NumReductions> reductions{};
+  size_t num = 0;
+  (add_reductions(States(), rules, reductions, num), ...);
+  return reductions;
+}
+
+template <typename... Rules>
+constexpr bool has_empty_rule(set<Rules...>) noexcept {
+  return ((sizeof_rhs(Rules()) == 0) || ...);
+}
+
+template <typename Lhs, typename... Rhs, typename... Nonterminals>
+constexpr size_t rule_lhs(bullet_rule<Lhs, set<>, Rhs...>,
+                          set<Nonterminals...>) noexcept {
+  return idx_of<0, Lhs, Nonterminals...>();
+}
+
+template <typename... Rules, typename Nonterminals>
+constexpr std::array<size_t, sizeof...(Rules)>
+init_rule_lhs(set<Rules...>, Nonterminals nonterminals) noexcept {
+  return {rule_lhs(Rules(), nonterminals)...};
+}
+
+template <typename... Rules>
+constexpr std::array<size_t, sizeof...(Rules)>
+init_rule_sizes(set<Rules...>) noexcept {
+  return {sizeof_rhs(Rules())...};
+}
+
+// Whether a state has more than one action for some terminal.
+template <typename Row, size_t NumStates>
+constexpr std::array<bool, NumStates>
+init_conflicts(std::array<Row, NumStates> const &shifts,
+               std::array<size_t, NumStates + 1> const &offsets) noexcept {
+  std::array<bool, NumStates> conflicts{};
+  for (size_t state = 0; state < NumStates; ++state) {
+    size_t num = offsets[state + 1] - offsets[state];
+    bool shifts_any = false;
+    for (auto &a : shifts[state].actions) {
+      shifts_any = shifts_any || a.type == action_type::Shift;
+    }
+    conflicts[state] = num > 1 || (num == 1 && shifts_any);
+  }
+  return conflicts;
+}
+
+// Shared packed parse forest of a GLR parse. A node is a symbol with the
+// range of tokens it spans. Nonterminals have one packed alternative per
+// derivation, whose children are nodes again, so common subtrees of
+// ambiguous parses are stored once.
+struct glr_forest {
+  static constexpr size_t none = std::numeric_limits<size_t>::max();
+
+  // Leaves have no alternatives, but a value: a token, or a nonterminal
+  // that was constructed while the parse was deterministic.
+  struct node {
+    size_t symbol = 0;
+    size_t start = 0;
+    size_t end = 0;
+    size_t alternatives = none;
+    size_t value = none;
+  };
+
+  struct packed {
+    size_t rule = 0;
+    size_t children = 0;
+    size_t num_children = 0;
+    size_t next = none;
+  };
+
+  std::vector<node> nodes;
+  std::vector<packed> alternatives;
+  std::vector<size_t> children;
+
+  void clear() noexcept {
+    nodes.clear();
+    alternatives.clear();
+    children.clear();
+  }
+
+  bool ambiguous(size_t n) const noexcept {
+    size_t first = nodes[n].alternatives;
+    return first != none && alternatives[first].next != none;
+  }
+
+  size_t num_ambiguous() const noexcept {
+    size_t num = 0;
+    for (size_t n = 0; n < nodes.size(); ++n) {
+      num += ambiguous(n);
+    }
+    return num;
+  }
+
+  // Adds the derivation `rule` with the `num` children that precede `last`
+  // in reverse order, unless `n` already has it.
+  void derive(size_t n, size_t rule, size_t const *last, size_t num) {
+    for (size_t a = nodes[n].alternatives; a != none;
+         a = alternatives[a].next) {
+      packed const &alternative = alternatives[a];
+      if (alternative.rule != rule) {
+        continue;
+      }
+      bool same = true;
+      for (size_t i = 0; i < num && same; ++i) {
+        same = children[alternative.children + i] == *(last - 1 - i);
+      }
+      if (same) {
+        return;
+      }
+    }
+    alternatives.push_back({rule, children.size(), num, nodes[n].alternatives});
+    nodes[n].alternatives = alternatives.size() - 1;
+    for (size_t i = 0; i < num; ++i) {
+      children.push_back(*(last - 1 - i));
+    }
+  }
+};
+
+// Picks the first derivation of every ambiguous node.
+struct first_alternative {
+  size_t operator()(glr_forest const &forest, size_t n) const noexcept {
+    return forest.nodes[n].alternatives;
+  }
+};
+
+// Generalized LR parser for grammars with conflicts, on the same grammar
+// description as `transition_table`. Where the LR(0) automaton has more than
+// one action, every one of them is taken: the stacks fork into a graph that
+// shares common prefixes and merges again in equal states, and reductions
+// build a `glr_forest` of all derivations. `evaluate` constructs the values
+// of one of them.
+//
+// While there is a single stack in states without conflicts, the parser
+// runs like an LR parser on a plain stack above a node of the graph, and
+// constructs values right away. Those values become forest leaves once a
+// reduction reaches below that stack or its top has to fork. Stack nodes,
+// edges and forest nodes live in pools that are reused by the next parse.
+// Rules must not be empty, and precedence declarations are not applied.
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals>
+class glr_table {
+  using lr = parse_table<Start, Rules, Nonterminals, Terminals>;
+  using rules = typename lr::rules;
+  using states = typename lr::states;
+  using values_table = transition_table<Start, Rules, Nonterminals, Terminals>;
+
+  static_assert(!has_empty_rule(rules()),
+                "GLR tables do not support empty rules");
+
+  static constexpr size_t none = glr_forest::none;
+
+public:
+  static constexpr std::array<decltype(make_row(Terminals(), set<>())),
+                              states::num_elements>
+      shifts = init_shift_rows(states(), rules(), Nonterminals(), Terminals());
+
+  static constexpr size_t num_reductions = count_reductions(states());
+
+  static constexpr std::array<size_t, states::num_elements + 1> offsets =
+      reduction_offsets(states());
+
+  static constexpr std::array<size_t, num_reductions> reductions =
+      collect_reductions<num_reductions>(states(), rules());
+
+  static constexpr std::array<bool, states::num_elements> conflicts =
+      init_conflicts(shifts, offsets);
+
+  static constexpr std::array<size_t, rules::num_elements> lhs =
+      init_rule_lhs(rules(), Nonterminals());
+
+  static constexpr std::array<size_t, rules::num_elements> sizes =
+      init_rule_sizes(rules());
+
+  static constexpr size_t accept_rule = idx_of<decltype(get_element<0>(
+      with_lhs(std::declval<Start>(), rules())))>(rules());
+
+private:
+  struct node {
+    size_t state = 0;
+    size_t level = 0;
+    size_t edges = none;
+    // Number of nodes below that have a single edge, so the path down
+    // to them is unique.
+    size_t linear = 0;
+    bool acted = false;
+  };
+
+  struct edge {
+    size_t to = 0;
+    size_t label = 0;
+    size_t next = none;
+  };
+
+  // An entry of the deterministic stack, whose value is on top of the
+  // evaluator's value stack.
+  struct entry {
+    size_t state = 0;
+    size_t level = 0;
+    size_t symbol = 0;
+  };
+
+  std::vector<node> nodes;
+  std::vector<edge> edges;
+  std::vector<size_t> heads;
+  std::vector<size_t> next_heads;
+  std::vector<size_t> pending;
+  std::vector<size_t> head_of = std::vector<size_t>(states::num_elements, none);
+  std::vector<size_t> level_nodes;
+  std::vector<size_t> path;
+  std::vector<std::pair<size_t, size_t>> walk;
+  std::vector<entry> line;
+  std::vector<typename values_table::value_type> leaves;
+  size_t base = 0;
+  bool deterministic = true;
+  size_t level = 0;
+  size_t root = none;
+  values_table evaluator;
+
+  size_t add_node(size_t state, size_t at) {
+    nodes.push_back({state, at});
+    return nodes.size() - 1;
+  }
+
+  size_t add_head(size_t state) {
+    heads.push_back(add_node(state, level));
+    head_of[state] = heads.back();
+    return heads.back();
+  }
+
+  size_t add_edge(size_t from, size_t to, size_t label) {
+    edges.push_back({to, label, nodes[from].edges});
+    nodes[from].linear =
+        nodes[from].edges == none ? nodes[to].linear + 1 : 0;
+    nodes[from].edges = edges.size() - 1;
+    return edges.size() - 1;
+  }
+
+  size_t add_leaf(size_t symbol, size_t start, size_t end,
+                  typename values_table::value_type &&value) {
+    leaves.push_back(std::move(value));
+    forest.nodes.push_back({symbol, start, end, none, leaves.size() - 1});
+    return forest.nodes.size() - 1;
+  }
+
+  size_t line_state() const noexcept {
+    return line.empty() ? nodes[base].state : line.back().state;
+  }
+
+  size_t line_level() const noexcept {
+    return line.empty() ? nodes[base].level : line.back().level;
+  }
+
+  // Runs the reductions of the deterministic stack. Returns false where
+  // its top has to fork, or a reduction reaches below it.
+  bool reduce_line() {
+    while (true) {
+      size_t state = line_state();
+      if (conflicts[state]) {
+        return false;
+      }
+      if (offsets[state] == offsets[state + 1]) {
+        return true;
+      }
+      size_t rule = reductions[offsets[state]];
+      if (sizes[rule] > line.size()) {
+        return false;
+      }
+      evaluator.eval(rule);
+      line.resize(line.size() - sizes[rule]);
+      if (rule == accept_rule) {
+        if (line.empty() && base == 0) {
+          root = add_leaf(Terminals::num_elements + lhs[rule], 0, level,
+                          std::move(evaluator.values.back()));
+          evaluator.values.pop_back();
+        }
+        return true;
+      }
+      line.push_back({lr::lr0_rows[line_state()]
+                          .actions[Terminals::num_elements + lhs[rule]]
+                          .idx,
+                      level, Terminals::num_elements + lhs[rule]});
+    }
+  }
+
+  // Moves the deterministic stack into the graph, with its values as
+  // forest leaves, and makes its top the only stack top.
+  void fork() {
+    size_t below = base;
+    size_t first = evaluator.values.size() - line.size();
+    for (size_t i = 0; i < line.size(); ++i) {
+      size_t leaf = add_leaf(line[i].symbol, nodes[below].level, line[i].level,
+                             std::move(evaluator.values[first + i]));
+      size_t next = add_node(line[i].state, line[i].level);
+      add_edge(next, below, leaf);
+      below = next;
+    }
+    evaluator.values.erase(evaluator.values.begin() + first,
+                           evaluator.values.end());
+    line.clear();
+    heads.assign(1, below);
+    head_of[nodes[below].state] = below;
+    deterministic = false;
+  }
+
+  // The node of `symbol` from `start` to the current level, shared by all
+  // reductions that derive it.
+  size_t forest_node(size_t symbol, size_t start) {
+    for (size_t n : level_nodes) {
+      if (forest.nodes[n].symbol == symbol && forest.nodes[n].start == start) {
+        return n;
+      }
+    }
+    forest.nodes.push_back({symbol, start, level});
+    level_nodes.push_back(forest.nodes.size() - 1);
+    return forest.nodes.size() - 1;
+  }
+
+  // Reduces `rule` along every path of its length from `from`. Only paths
+  // that start with `first` are taken, unless it is `none`.
+  void reduce_paths(size_t from, size_t rule, size_t remaining, size_t first) {
+    if (first == none && remaining <= nodes[from].linear) {
+      size_t size = path.size();
+      for (; remaining > 0; --remaining) {
+        edge const &down = edges[nodes[from].edges];
+        path.push_back(down.label);
+        from = down.to;
+      }
+      reduce(from, rule);
+      path.resize(size);
+      return;
+    }
+    if (remaining == 0) {
+      reduce(from, rule);
+      return;
+    }
+    for (size_t e = nodes[from].edges; e != none; e = edges[e].next) {
+      if (first != none && e != first) {
+        continue;
+      }
+      path.push_back(edges[e].label);
+      reduce_paths(edges[e].to, rule, remaining - 1, none);
+      path.pop_back();
+    }
+  }
+
+  void reduce_all(size_t from, size_t first) {
+    size_t state = nodes[from].state;
+    for (size_t r = offsets[state]; r < offsets[state + 1]; ++r) {
+      reduce_paths(from, reductions[r], sizes[reductions[r]], first);
+    }
+  }
+
+  // Reduces `rule` whose right hand side is the end of `path`, down to
+  // `below`, and pushes the goto of its nonterminal. A goto into a state
+  // that is on top already merges the stacks. If that adds an edge to a top
+  // whose reductions ran already, they run again through the new edge.
+  void reduce(size_t below, size_t rule) {
+    size_t n = forest_node(Terminals::num_elements + lhs[rule],
+                           nodes[below].level);
+    forest.derive(n, rule, path.data() + path.size(), sizes[rule]);
+    if (rule == accept_rule) {
+      if (below == 0) {
+        root = n;
+      }
+      return;
+    }
+    size_t state = lr::lr0_rows[nodes[below].state]
+                       .actions[Terminals::num_elements + lhs[rule]]
+                       .idx;
+    size_t top = head_of[state];
+    if (top == none) {
+      add_edge(add_head(state), below, n);
+      pending.push_back(heads.back());
+      return;
+    }
+    for (size_t e = nodes[top].edges; e != none; e = edges[e].next) {
+      if (edges[e].to == below) {
+        return;
+      }
+    }
+    size_t e = add_edge(top, below, n);
+    if (nodes[top].acted) {
+      reduce_all(top, e);
+    }
+  }
+
+  // Runs the reductions of all stack tops of the current level.
+  void reduce_level() {
+    if (deterministic) {
+      if (reduce_line()) {
+        return;
+      }
+      fork();
+    }
+    pending = heads;
+    while (!pending.empty()) {
+      size_t top = pending.back();
+      pending.pop_back();
+      nodes[top].acted = true;
+      reduce_all(top, none);
+    }
+  }
+
+  // Pushes the value of leaf `n`, or starts evaluating its children.
+  template <typename Choose> void visit(size_t n, Choose &choose) {
+    glr_forest::node const &symbol = forest.nodes[n];
+    if (symbol.alternatives == none) {
+      evaluator.values.push_back(std::move(leaves[symbol.value]));
+    } else {
+      walk.push_back({choose(forest, n), 0});
+    }
+  }
+
+  // Evaluates the derivation below `n` in post order, like the LR parse
+  // would have, without recursing as deep as the derivation.
+  template <typename Choose> void evaluate_node(size_t n, Choose &choose) {
+    visit(n, choose);
+    while (!walk.empty()) {
+      auto [a, child] = walk.back();
+      glr_forest::packed const &alternative = forest.alternatives[a];
+      if (child < alternative.num_children) {
+        ++walk.back().second;
+        visit(forest.children[alternative.children + child], choose);
+      } else {
+        evaluator.eval(alternative.rule);
+        walk.pop_back();
+      }
+    }
+  }
+
+public:
+  glr_forest forest;
+
+  glr_table() { reset(); }
+
+  void reset() {
+    nodes.clear();
+    edges.clear();
+    heads.clear();
+    line.clear();
+    leaves.clear();
+    level_nodes.clear();
+    forest.clear();
+    evaluator.reset();
+    std::fill(head_of.begin(), head_of.end(), none);
+    level = 0;
+    root = none;
+    base = add_node(0, 0);
+    deterministic = true;
+  }
+
+  // Number of stacks the parse has split into at the current token.
+  size_t num_heads() const noexcept {
+    return deterministic ? 1 : heads.size();
+  }
+
+  template <typename Token> void read_token(Token &&token) {
+    size_t const terminal_idx = idx_of(token, Terminals());
+    reduce_level();
+    evaluator.push_value(std::move(token));
+
+    if (deterministic) {
+      action const &shift = shifts[line_state()].actions[terminal_idx];
+      if (shift.type != action_type::Shift) {
+        throw std::runtime_error("Invalid input token");
+      }
+      ++level;
+      line.push_back({shift.idx, level, terminal_idx});
+      return;
+    }
+
+    size_t leaf = add_leaf(terminal_idx, level, level + 1,
+                           std::move(evaluator.values.back()));
+    evaluator.values.pop_back();
+    for (size_t top : heads) {
+      head_of[nodes[top].state] = none;
+    }
+    next_heads.swap(heads);
+    heads.clear();
+    level_nodes.clear();
+    ++level;
+    for (size_t top : next_heads) {
+      action const &shift = shifts[nodes[top].state].actions[terminal_idx];
+      if (shift.type != action_type::Shift) {
+        continue;
+      }
+      size_t next = head_of[shift.idx];
+      add_edge(next == none ? add_head(shift.idx) : next, top, leaf);
+    }
+    if (heads.empty()) {
+      throw std::runtime_error("Invalid input token");
+    }
+    if (heads.size() == 1) {
+      // Continue deterministically on top of the only stack.
+      base = heads[0];
+      head_of[nodes[base].state] = none;
+      heads.clear();
+      deterministic = true;
+    }
+  }
+
+  // Runs the final reductions once the input is complete, and returns
+  // whether any of them derived the start symbol.
+  bool finish() {
+    reduce_level();
+    return root != none;
+  }
+
+  // The forest node of the start symbol, after a successful `finish`.
+  size_t result() const noexcept { return root; }
+
+  // Constructs the values of one derivation, picking the alternative
+  // `choose(forest, node)` at every node. Values are moved out of the
+  // forest's leaves, so this works once per parse.
+  template <typename Choose = first_alternative>
+  Start &evaluate(Choose &&choose = Choose()) {
+    if (root == none) {
+      throw std::runtime_error{"Parse result not available yet"};
+    }
+    evaluate_node(root, choose);
+    return get_symbol<Start>(evaluator.values.back());
+  }
+};
+
+} // namespace parser
+
+#endif
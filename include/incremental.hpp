@@ -0,0 +1,209 @@
+#if !defined(INCREMENTAL_HPP)
+#define INCREMENTAL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace parser {
+
+// Keeps the elements of a document `Open Element Separator ... Close` parsed
+// across edits. The start of every element is a checkpoint: the parse stack
+// there is always the predicted `context`, so parsing can resume at any of
+// them. An edit re-parses from the last checkpoint before it, until an
+// element starts behind the edit where an old one started, too. From there
+// on the old elements are reused as they are.
+template <typename Table, typename Lexer, typename Open, typename Element,
+          typename Separator, typename Close>
+class incremental_parser {
+  enum class boundary { separator, close, failed };
+
+  Table table;
+  std::vector<size_t> context;
+  std::vector<Element> values;
+  std::vector<size_t> starts;
+  size_t close = 0;
+  size_t num_reparsed = 0;
+
+  // Parses the element at `offset` on top of `context` into `out`. Moves
+  // `offset` to the start of the next element, or to the closing token.
+  boundary parse_element(std::string_view input, size_t &offset,
+                         std::vector<Element> &out) {
+    size_t floor = context.size();
+    table.restore(context);
+    Lexer tokens(input, offset);
+    boundary result = boundary::failed;
+    try {
+      bool done = false;
+      while (!done) {
+        bool more = tokens.next([&](auto &&token) {
+          using Token = std::decay_t<decltype(token)>;
+          if (table.read_token_above(std::move(token), floor) !=
+              read_status::floor_reached) {
+            return;
+          }
+          done = true;
+          if (table.values.size() != 1) {
+            return;
+          }
+          out.push_back(std::move(get_symbol<Element>(table.values.back())));
+          if constexpr (std::is_same<Token, Separator>::value) {
+            offset = tokens.offset();
+            result = boundary::separator;
+          } else if constexpr (std::is_same<Token, Close>::value) {
+            offset = tokens.token_start();
+            // The sequence has to end the document.
+            if (!tokens.next([](auto &&) {})) {
+              result = boundary::close;
+            }
+          }
+        });
+        if (!more) {
+          return boundary::failed;
+        }
+      }
+    } catch (std::exception const &) {
+      return boundary::failed;
+    }
+    return result;
+  }
+
+  // Whether the input at `offset` is only the closing token, whose start
+  // `offset` is moved to.
+  static bool closes(std::string_view input, size_t &offset) {
+    try {
+      Lexer tokens(input, offset);
+      bool closed = false;
+      tokens.next([&closed](auto &&token) {
+        closed = std::is_same<std::decay_t<decltype(token)>, Close>::value;
+      });
+      size_t start = tokens.token_start();
+      if (closed && !tokens.next([](auto &&) {})) {
+        offset = start;
+        return true;
+      }
+    } catch (std::exception const &) {
+    }
+    return false;
+  }
+
+  // Parses elements from `offset` on, which replace the old elements from
+  // `first` on. Stops early at an element that starts at or behind
+  // `unchanged`, where the input equals the old input shifted by `delta`,
+  // if an old element started at the same place.
+  bool reparse(std::string_view input, size_t first, size_t offset,
+               size_t unchanged, std::ptrdiff_t delta) {
+    std::vector<Element> fresh;
+    std::vector<size_t> fresh_starts;
+    while (true) {
+      if (offset >= unchanged) {
+        size_t old_offset = offset - delta;
+        auto old = std::lower_bound(starts.begin() + first, starts.end(),
+                                    old_offset);
+        if (old != starts.end() && *old == old_offset) {
+          splice(first, old - starts.begin(), fresh, fresh_starts, delta);
+          close += delta;
+          return true;
+        }
+      }
+      if (first == 0 && fresh.empty() && closes(input, offset)) {
+        splice(first, starts.size(), fresh, fresh_starts, delta);
+        close = offset;
+        return true;
+      }
+      fresh_starts.push_back(offset);
+      switch (parse_element(input, offset, fresh)) {
+      case boundary::separator:
+        continue;
+      case boundary::close:
+        splice(first, starts.size(), fresh, fresh_starts, delta);
+        close = offset;
+        return true;
+      default:
+        return false;
+      }
+    }
+  }
+
+  // Replaces the old elements `[first, last)` by `fresh`, and moves the
+  // starts of the elements behind them by `delta`.
+  void splice(size_t first, size_t last, std::vector<Element> &fresh,
+              std::vector<size_t> &fresh_starts, std::ptrdiff_t delta) {
+    std::vector<Element> merged;
+    merged.reserve(values.size() - (last - first) + fresh.size());
+    std::move(values.begin(), values.begin() + first,
+              std::back_inserter(merged));
+    std::move(fresh.begin(), fresh.end(), std::back_inserter(merged));
+    std::move(values.begin() + last, values.end(), std::back_inserter(merged));
+    values = std::move(merged);
+
+    for (size_t i = last; i < starts.size(); ++i) {
+      starts[i] += delta;
+    }
+    starts.erase(starts.begin() + first, starts.begin() + last);
+    starts.insert(starts.begin() + first, fresh_starts.begin(),
+                  fresh_starts.end());
+    num_reparsed = fresh.size();
+  }
+
+public:
+  // `context` is the stack every element is parsed on, see
+  // `predict_context`.
+  explicit incremental_parser(std::vector<size_t> context)
+      : context(std::move(context)) {}
+
+  std::vector<Element> const &elements() const noexcept { return values; }
+
+  // Number of elements the last `parse` or `edit` had to parse.
+  size_t reparsed() const noexcept { return num_reparsed; }
+
+  // Parses the whole document. On failure no elements are kept.
+  bool parse(std::string_view input) {
+    values.clear();
+    starts.clear();
+    num_reparsed = 0;
+    try {
+      Lexer tokens(input);
+      bool opened = false;
+      tokens.next([&opened](auto &&token) {
+        opened = std::is_same<std::decay_t<decltype(token)>, Open>::value;
+      });
+      if (!opened) {
+        return false;
+      }
+      if (reparse(input, 0, tokens.offset(), input.size() + 1, 0)) {
+        return true;
+      }
+    } catch (std::exception const &) {
+    }
+    values.clear();
+    starts.clear();
+    return false;
+  }
+
+  // Updates the elements after the old input's bytes `[begin, end)` were
+  // replaced by `size` bytes, which gave `input`. Edits that touch the
+  // opening or closing token parse the whole document again. On failure the
+  // old elements are kept.
+  bool edit(std::string_view input, size_t begin, size_t end, size_t size) {
+    if (starts.empty() || begin < starts.front() || end > close) {
+      return parse(input);
+    }
+    size_t first = std::upper_bound(starts.begin(), starts.end(), begin) -
+                   starts.begin() - 1;
+    std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(size) -
+                           static_cast<std::ptrdiff_t>(end - begin);
+    return reparse(input, first, starts[first], begin + size, delta);
+  }
+};
+
+} // namespace parser
+
+#endif
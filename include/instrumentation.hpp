@@ -0,0 +1,221 @@
+#if !defined(INSTRUMENTATION_HPP)
+#define INSTRUMENTATION_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace parser {
+
+// Aggregated counters of one grammar, see `instrumentation`. `errors` and
+// `lookups` count the errors and table lookups in every state, and `columns`
+// the lookups of every terminal and then nonterminal, all by discovery
+// order whatever the table's layout.
+template <size_t NumRules, size_t NumStates, size_t NumSymbols>
+struct parse_stats {
+  uint64_t shifts = 0;
+  uint64_t gotos = 0;
+  uint64_t max_stack_depth = 0;
+  uint64_t max_values = 0;
+  std::array<uint64_t, NumRules> reductions{};
+  std::array<uint64_t, NumStates> errors{};
+  std::array<uint64_t, NumStates> lookups{};
+  std::array<uint64_t, NumSymbols> columns{};
+
+  uint64_t total_reductions() const noexcept {
+    uint64_t total = 0;
+    for (auto count : reductions) {
+      total += count;
+    }
+    return total;
+  }
+
+  uint64_t total_errors() const noexcept {
+    uint64_t total = 0;
+    for (auto count : errors) {
+      total += count;
+    }
+    return total;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream,
+                                  parse_stats const &stats) {
+    stream << "shifts " << stats.shifts << ", gotos " << stats.gotos
+           << ", max stack depth " << stats.max_stack_depth
+           << ", max values " << stats.max_values << '\n';
+    for (size_t i = 0; i < NumRules; ++i) {
+      if (stats.reductions[i] > 0) {
+        stream << "  rule " << i << ": " << stats.reductions[i]
+               << " reductions\n";
+      }
+    }
+    for (size_t i = 0; i < NumStates; ++i) {
+      if (stats.errors[i] > 0) {
+        stream << "  state " << i << ": " << stats.errors[i] << " errors\n";
+      }
+    }
+    return stream;
+  }
+
+  // Writes the lookup counts as a struct `name` for `profile_guided`, to be
+  // included by the grammar's header.
+  void write_profile(std::ostream &stream, std::string_view name) const {
+    auto write = [&stream](char const *member, auto const &counts) {
+      stream << "  static constexpr std::array<uint64_t, " << counts.size()
+             << "> " << member << " = {";
+      for (size_t i = 0; i < counts.size(); ++i) {
+        stream << (i % 6 == 0 ? "\n      " : " ") << counts[i]
+               << (i + 1 < counts.size() ? "," : "");
+      }
+      stream << "};\n";
+    };
+    stream << "struct " << name << " {\n";
+    write("states", lookups);
+    write("symbols", columns);
+    stream << "};\n";
+  }
+};
+
+// Hooks of a table without instrumentation. They are empty, so every call
+// in the parse loop compiles to nothing.
+struct null_counters {
+  static constexpr void shift() noexcept {}
+  static constexpr void reduce(size_t) noexcept {}
+  static constexpr void go_to() noexcept {}
+  static constexpr void stack_depth(size_t) noexcept {}
+  static constexpr void values(size_t) noexcept {}
+  static constexpr void error(size_t) noexcept {}
+  static constexpr void lookup(size_t, size_t) noexcept {}
+};
+
+// Every thread counts into its own block, and `snapshot` sums the blocks of
+// all threads on demand. A counter is only ever written by its owning
+// thread, so it is updated with relaxed loads and stores instead of atomic
+// read-modify-write instructions. `Tag` keeps grammars of the same size
+// apart.
+template <typename Tag, size_t NumRules, size_t NumStates, size_t NumSymbols>
+class thread_counters {
+  using counter = std::atomic<uint64_t>;
+
+  struct block {
+    counter shifts{0};
+    counter gotos{0};
+    counter max_stack_depth{0};
+    counter max_values{0};
+    std::array<counter, NumRules> reductions{};
+    std::array<counter, NumStates> errors{};
+    std::array<counter, NumStates> lookups{};
+    std::array<counter, NumSymbols> columns{};
+  };
+
+  struct registry {
+    std::mutex mutex;
+    std::vector<block const *> live;
+    parse_stats<NumRules, NumStates, NumSymbols> retired;
+  };
+
+  static registry &shared() {
+    static registry instance;
+    return instance;
+  }
+
+  // Registers the block of the current thread, and folds its counts into
+  // `retired` when the thread exits.
+  struct owner {
+    block counts;
+    owner() {
+      registry &r = shared();
+      std::lock_guard lock(r.mutex);
+      r.live.push_back(&counts);
+    }
+    ~owner() {
+      registry &r = shared();
+      std::lock_guard lock(r.mutex);
+      add(r.retired, counts);
+      r.live.erase(std::find(r.live.begin(), r.live.end(), &counts));
+    }
+  };
+
+  static block &local() {
+    thread_local owner instance;
+    return instance.counts;
+  }
+
+  static void increment(counter &c) noexcept {
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  static void raise(counter &c, uint64_t value) noexcept {
+    if (value > c.load(std::memory_order_relaxed)) {
+      c.store(value, std::memory_order_relaxed);
+    }
+  }
+
+  static void add(parse_stats<NumRules, NumStates, NumSymbols> &stats,
+                  block const &b) {
+    stats.shifts += b.shifts.load(std::memory_order_relaxed);
+    stats.gotos += b.gotos.load(std::memory_order_relaxed);
+    stats.max_stack_depth =
+        std::max(stats.max_stack_depth,
+                 b.max_stack_depth.load(std::memory_order_relaxed));
+    stats.max_values = std::max(
+        stats.max_values, b.max_values.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < NumRules; ++i) {
+      stats.reductions[i] += b.reductions[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < NumStates; ++i) {
+      stats.errors[i] += b.errors[i].load(std::memory_order_relaxed);
+      stats.lookups[i] += b.lookups[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < NumSymbols; ++i) {
+      stats.columns[i] += b.columns[i].load(std::memory_order_relaxed);
+    }
+  }
+
+public:
+  static void shift() noexcept { increment(local().shifts); }
+  static void reduce(size_t rule_idx) noexcept {
+    increment(local().reductions[rule_idx]);
+  }
+  static void go_to() noexcept { increment(local().gotos); }
+  static void stack_depth(size_t depth) noexcept {
+    raise(local().max_stack_depth, depth);
+  }
+  static void values(size_t size) noexcept { raise(local().max_values, size); }
+  static void error(size_t state) noexcept { increment(local().errors[state]); }
+  static void lookup(size_t state, size_t symbol) noexcept {
+    block &b = local();
+    increment(b.lookups[state]);
+    increment(b.columns[symbol]);
+  }
+
+  static parse_stats<NumRules, NumStates, NumSymbols> snapshot() {
+    registry &r = shared();
+    std::lock_guard lock(r.mutex);
+    parse_stats<NumRules, NumStates, NumSymbols> stats = r.retired;
+    for (block const *b : r.live) {
+      add(stats, *b);
+    }
+    return stats;
+  }
+};
+
+// Instrumentation policies of a `transition_table`.
+struct no_instrumentation {
+  template <typename Tag, size_t NumRules, size_t NumStates, size_t NumSymbols>
+  using counters = null_counters;
+};
+
+struct instrumentation {
+  template <typename Tag, size_t NumRules, size_t NumStates, size_t NumSymbols>
+  using counters = thread_counters<Tag, NumRules, NumStates, NumSymbols>;
+};
+
+} // namespace parser
+
+#endif
@@ -0,0 +1,146 @@
+#if !defined(INTERNER_HPP)
+#define INTERNER_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "adaptive_radix_tree.hpp"
+
+namespace parser {
+
+// Maps strings to small ids that stay the same for the whole process, so
+// strings that repeat across documents, like the keys of records, are stored
+// and compared as integers. New ids are handed out under a lock. Every
+// thread caches the ids it has seen in its own radix tree, so a repeated
+// string is looked up without synchronization, and the strings of ids are
+// read without a lock as well. Once `capacity` strings are interned, new
+// ones get `npos` and have to be stored by their users, so input with ever
+// new strings cannot grow the interner without bound. `Tag` keeps the ids
+// of different uses apart.
+template <typename Tag> class interner {
+  static constexpr size_t first_chunk_size = 64;
+  static constexpr size_t num_chunks = 15;
+
+public:
+  static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+  // Most strings the interner holds, about two million.
+  static constexpr size_t capacity =
+      first_chunk_size * ((size_t{1} << num_chunks) - 1);
+
+  // Most strings a thread caches before it starts its cache over.
+  static constexpr size_t cache_capacity = 1 << 16;
+
+private:
+  // Strings by id, in chunks of twice the size of the one before. Chunks
+  // are never moved or freed, and a chunk is published before any id in it
+  // is handed out.
+  struct registry {
+    std::mutex mutex;
+    growing_radix_tree ids;
+    std::array<std::atomic<std::string *>, num_chunks> chunks{};
+    std::atomic<size_t> size{0};
+
+    ~registry() {
+      for (auto &chunk : chunks) {
+        delete[] chunk.load(std::memory_order_relaxed);
+      }
+    }
+  };
+
+  static registry &shared() {
+    static registry instance;
+    return instance;
+  }
+
+  static growing_radix_tree &local() {
+    thread_local growing_radix_tree cache;
+    return cache;
+  }
+
+  // Chunk of `id` and its position there.
+  static constexpr std::pair<size_t, size_t> locate(size_t id) noexcept {
+    size_t chunk = std::bit_width(id / first_chunk_size + 1) - 1;
+    return {chunk, id - first_chunk_size * ((size_t{1} << chunk) - 1)};
+  }
+
+  // Stores `name` as the next id. Only call this under the registry's lock.
+  static void append(registry &r, std::string_view name) {
+    size_t id = r.size.load(std::memory_order_relaxed);
+    auto [chunk, position] = locate(id);
+    std::string *strings = r.chunks[chunk].load(std::memory_order_relaxed);
+    if (!strings) {
+      strings = new std::string[first_chunk_size << chunk];
+      r.chunks[chunk].store(strings, std::memory_order_release);
+    }
+    strings[position] = name;
+    r.size.store(id + 1, std::memory_order_release);
+  }
+
+public:
+  // Id of `name`, which is assigned if `name` is new, or `npos` if it is new
+  // and the interner is full.
+  static uint32_t intern(std::string_view name) {
+    growing_radix_tree &cache = local();
+    if (size_t id = cache.find(name); id != empty_slot) {
+      return static_cast<uint32_t>(id);
+    }
+    registry &r = shared();
+    size_t id = empty_slot;
+    {
+      std::lock_guard lock(r.mutex);
+      size_t next = r.size.load(std::memory_order_relaxed);
+      id = next < capacity ? r.ids.insert(name, next) : r.ids.find(name);
+      if (id == next) {
+        append(r, name);
+      }
+    }
+    if (id == empty_slot) {
+      return npos;
+    }
+    if (cache.size() >= cache_capacity) {
+      cache = growing_radix_tree();
+    }
+    cache.insert(name, id);
+    return static_cast<uint32_t>(id);
+  }
+
+  // Id of `name` if it was interned before, or `npos`.
+  static uint32_t find(std::string_view name) {
+    if (size_t id = local().find(name); id != empty_slot) {
+      return static_cast<uint32_t>(id);
+    }
+    registry &r = shared();
+    std::lock_guard lock(r.mutex);
+    size_t id = r.ids.find(name);
+    return id == empty_slot ? npos : static_cast<uint32_t>(id);
+  }
+
+  // The string of an id, or the empty string for `npos`. Interned strings
+  // are never moved or freed.
+  static std::string_view name(uint32_t id) {
+    if (id == npos) {
+      return {};
+    }
+    auto [chunk, position] = locate(id);
+    return shared().chunks[chunk].load(std::memory_order_acquire)[position];
+  }
+
+  static size_t size() {
+    return shared().size.load(std::memory_order_acquire);
+  }
+
+  // Whether new strings get `npos`.
+  static bool full() { return size() >= capacity; }
+};
+
+} // namespace parser
+
+#endif
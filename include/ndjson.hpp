@@ -0,0 +1,205 @@
+#if !defined(NDJSON_HPP)
+#define NDJSON_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace parser {
+
+enum class delivery {
+  in_order,
+  unordered,
+};
+
+// Parses newline delimited documents on a pool of worker threads. Every
+// worker owns one `Parser`, so its `transition_table`, stacks and arena are
+// reused for all records the worker sees. `Parser` is any default
+// constructible type with a `parse(std::string_view)` member, like the example
+// scanners. A record whose parse throws fails on its own, and the records
+// around it are still delivered.
+template <typename Parser> class ndjson_parser {
+public:
+  using result_type =
+      decltype(std::declval<Parser &>().parse(std::string_view()));
+
+private:
+  // The result of a record, or why it failed.
+  struct record {
+    size_t line = 0;
+    size_t offset = 0;
+    std::optional<result_type> result;
+    std::exception_ptr error;
+  };
+
+  struct chunk {
+    std::string_view text;
+    size_t first_line = 0;
+    size_t first_offset = 0;
+    std::vector<record> records;
+    bool done = false;
+  };
+
+  size_t chunk_size;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable chunk_done;
+  std::deque<chunk> chunks;
+  std::deque<size_t> completed;
+  size_t next_chunk = 0;
+  bool stopping = false;
+
+  static void parse_chunk(Parser &parser, chunk &c) {
+    size_t line = c.first_line;
+    std::string_view text = c.text;
+    while (!text.empty()) {
+      size_t end_idx = std::min(text.find('\n'), text.size());
+      std::string_view record = text.substr(0, end_idx);
+      if (!record.empty() && record.back() == '\r') {
+        record.remove_suffix(1);
+      }
+      if (!record.empty()) {
+        auto &r = c.records.emplace_back();
+        r.line = line;
+        r.offset = c.first_offset + (record.data() - c.text.data());
+        try {
+          r.result.emplace(parser.parse(record));
+        } catch (...) {
+          r.error = std::current_exception();
+        }
+      }
+      text.remove_prefix(std::min(end_idx + 1, text.size()));
+      ++line;
+    }
+  }
+
+  void work() {
+    Parser parser;
+    std::unique_lock lock(mutex);
+    while (true) {
+      work_ready.wait(lock,
+                      [&] { return stopping || next_chunk < chunks.size(); });
+      if (stopping) {
+        return;
+      }
+      size_t idx = next_chunk++;
+      chunk &c = chunks[idx];
+      lock.unlock();
+      parse_chunk(parser, c);
+      lock.lock();
+      c.done = true;
+      completed.push_back(idx);
+      chunk_done.notify_all();
+    }
+  }
+
+  void split(std::string_view buffer) {
+    size_t line = 0;
+    size_t offset = 0;
+    while (!buffer.empty()) {
+      size_t cut = std::min(chunk_size, buffer.size());
+      if (cut < buffer.size()) {
+        cut = std::min(buffer.find('\n', cut), buffer.size() - 1) + 1;
+      }
+      chunk &c = chunks.emplace_back();
+      c.text = buffer.substr(0, cut);
+      c.first_line = line;
+      c.first_offset = offset;
+      line += std::count(c.text.begin(), c.text.end(), '\n');
+      offset += cut;
+      buffer.remove_prefix(cut);
+    }
+  }
+
+public:
+  explicit ndjson_parser(
+      size_t num_workers = std::thread::hardware_concurrency(),
+      size_t chunk_size = 1 << 20)
+      : chunk_size(std::max<size_t>(chunk_size, 1)) {
+    num_workers = std::max<size_t>(num_workers, 1);
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers.emplace_back([this] { work(); });
+    }
+  }
+
+  ndjson_parser(ndjson_parser const &) = delete;
+  ndjson_parser &operator=(ndjson_parser const &) = delete;
+
+  ~ndjson_parser() {
+    {
+      std::lock_guard lock(mutex);
+      stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  size_t num_workers() const noexcept { return workers.size(); }
+
+  // Calls `on_record(line, result)` on the calling thread for every non-empty
+  // line of `buffer` that parsed, and `on_error(line, offset, error)` with the
+  // line's byte offset in `buffer` and the exception for every other one.
+  // With `delivery::in_order` the records arrive in input order, otherwise
+  // chunk by chunk as the workers finish them.
+  template <typename Callback, typename ErrorCallback>
+  void parse(std::string_view buffer, delivery order, Callback &&on_record,
+             ErrorCallback &&on_error) {
+    std::unique_lock lock(mutex);
+    chunks.clear();
+    completed.clear();
+    next_chunk = 0;
+    split(buffer);
+    work_ready.notify_all();
+
+    for (size_t delivered = 0; delivered < chunks.size(); ++delivered) {
+      size_t idx = delivered;
+      if (order == delivery::in_order) {
+        chunk_done.wait(lock, [&] { return chunks[idx].done; });
+      } else {
+        chunk_done.wait(lock, [&] { return !completed.empty(); });
+        idx = completed.front();
+        completed.pop_front();
+      }
+      chunk &c = chunks[idx];
+      lock.unlock();
+      for (auto &r : c.records) {
+        if (r.error) {
+          on_error(r.line, r.offset, r.error);
+        } else {
+          on_record(r.line, std::move(*r.result));
+        }
+      }
+      c.records.clear();
+      lock.lock();
+    }
+  }
+
+  // Like above, but rethrows the first failure after all records that
+  // parsed have been delivered.
+  template <typename Callback>
+  void parse(std::string_view buffer, delivery order, Callback &&on_record) {
+    std::exception_ptr first;
+    parse(buffer, order, std::forward<Callback>(on_record),
+          [&first](size_t, size_t, std::exception_ptr error) {
+            first = first ? first : error;
+          });
+    if (first) {
+      std::rethrow_exception(first);
+    }
+  }
+};
+
+} // namespace parser
+
+#endif
@@ -3,13 +3,18 @@
 
 #include <array>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <string_view>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "arena.hpp"
+#include "instrumentation.hpp"
+
 namespace parser {
 
 template <bool Cond, typename If, typename Else> struct if_t {};
@@ -45,6 +50,13 @@ constexpr size_t sizeof_rhs(bullet_rule<Lhs, set<Seen...>, Rhs...>) noexcept {
   return sizeof...(Rhs);
 }
 
+template <typename... Rules>
+constexpr size_t max_sizeof_rhs(set<Rules...>) noexcept {
+  size_t max = 0;
+  ((max = sizeof_rhs(Rules()) > max ? sizeof_rhs(Rules()) : max), ...);
+  return max;
+}
+
 template <typename Lhs, typename... Rhs>
 constexpr auto make_rule(Lhs, Rhs...) -> bullet_rule<Lhs, set<>, Rhs...>;
 
@@ -53,6 +65,11 @@ constexpr bool contains(set<T...>, Element) noexcept {
   return (std::is_same<Element, T>::value || ... || false);
 }
 
+template <typename Element, typename... T>
+constexpr bool has_element(set<T...>) noexcept {
+  return (std::is_same<Element, T>::value || ... || false);
+}
+
 template <typename... T> constexpr bool empty(set<T...>) noexcept {
   return sizeof...(T) == 0;
 }
@@ -324,11 +341,17 @@ enum class action_type {
   Accept,
 };
 
+// For shifts and gotos, `pop_nr` counts the unit rules that are applied to
+// the pushed value right away, and `produce_fn` is the index of their chain,
+// see `unit_chain_set`.
 struct action {
   action_type type = action_type::Unreachable;
   size_t idx = 0;
   size_t pop_nr = 0;
   size_t produce_fn = 0;
+
+  friend constexpr bool operator==(action const &, action const &) = default;
+
   friend std::ostream &operator<<(std::ostream &stream, action const &a) {
     switch (a.type) {
     case action_type::Unreachable:
@@ -388,6 +411,9 @@ constexpr size_t idx_of(set<Symbol, Symbols...> const &) noexcept {
 template <typename... Symbols> struct transition_table_row {
   std::array<action, sizeof...(Symbols)> actions;
 
+  friend constexpr bool operator==(transition_table_row const &,
+                                   transition_table_row const &) = default;
+
   friend std::ostream &operator<<(std::ostream &stream,
                                   transition_table_row const &row) {
     for (auto &a : row.actions) {
@@ -413,7 +439,8 @@ template <typename... Terminals, typename... Nonterminals>
 constexpr auto make_row(set<Terminals...>, set<Nonterminals...>) noexcept
     -> transition_table_row<Terminals..., Nonterminals...>;
 
-std::ostream &operator<<(std::ostream &stream, std::vector<size_t> const &vec) {
+inline std::ostream &operator<<(std::ostream &stream,
+                                std::vector<size_t> const &vec) {
   for (auto i : vec) {
     stream << i << ", ";
   }
@@ -422,6 +449,43 @@ std::ostream &operator<<(std::ostream &stream, std::vector<size_t> const &vec) {
 
 template <typename Lhs, typename... Rhs> struct rule {};
 
+enum class associativity { left, right, nonassoc };
+
+// Base of operator terminals. A rule takes the precedence of its last
+// terminal that has one. Where a state could both reduce such a rule and
+// shift such a terminal, the higher level wins, and on equal levels left
+// associativity reduces, right associativity shifts and `nonassoc` makes the
+// token invalid, like in yacc.
+template <size_t Level, associativity Associativity> struct precedence {
+  static_assert(Level > 0, "Precedence levels start at 1");
+  static constexpr size_t precedence_level = Level;
+  static constexpr associativity precedence_associativity = Associativity;
+};
+
+template <size_t Level>
+using left_assoc = precedence<Level, associativity::left>;
+
+template <size_t Level>
+using right_assoc = precedence<Level, associativity::right>;
+
+template <size_t Level>
+using nonassoc = precedence<Level, associativity::nonassoc>;
+
+// Precedence level of a terminal, 0 without a declaration.
+template <typename Symbol> constexpr size_t precedence_of() noexcept {
+  if constexpr (requires { Symbol::precedence_level; }) {
+    return Symbol::precedence_level;
+  } else {
+    return 0;
+  }
+}
+
+template <typename... Rhs> constexpr size_t rhs_precedence() noexcept {
+  size_t level = 0;
+  ((level = precedence_of<Rhs>() > 0 ? precedence_of<Rhs>() : level), ...);
+  return level;
+}
+
 constexpr auto to_bullet_rules(set<>) noexcept -> set<>;
 
 template <typename Lhs, typename... Rhs, typename... Rules>
@@ -435,42 +499,25 @@ constexpr auto to_tuple(set<Ts...>) noexcept -> std::tuple<Ts...>;
 template <typename... Ts>
 constexpr auto to_variant(set<Ts...>) noexcept -> std::variant<Ts...>;
 
-template <typename Prefix, typename... Prefixes, typename Rule,
-          typename... Rules>
-constexpr bool is_prefix(set<Prefix, Prefixes...>,
-                         set<Rule, Rules...>) noexcept {
-  if constexpr (std::is_same<Prefix, Rule>::value) {
-    if constexpr (sizeof...(Prefixes) == 0) {
-      return true;
-    } else if constexpr (sizeof...(Rules) > 0) {
-      return is_prefix(set<Prefixes...>(), set<Rules...>());
-    } else {
-      return false;
-    }
-  } else {
-    return false;
-  }
-}
-
-template <size_t Idx, typename FindState, typename State, typename... States>
-constexpr size_t idx_from_prefix() noexcept {
-  if constexpr (is_prefix(FindState(), State())) {
-    return Idx;
-  } else {
-    return idx_from_prefix<Idx + 1, FindState, States...>();
-  }
-}
+template <typename Symbol, typename... State, typename... Rules,
+          typename... Nonterminals>
+constexpr auto go_to_state(set<State...> state, set<Rules...> rules,
+                           set<Nonterminals...> nonterminals) noexcept
+    -> decltype(closures(go_to(std::declval<Symbol>(), state), rules,
+                         nonterminals));
 
 template <typename... State, typename... Nonterminals, typename... States,
-          typename Symbol>
-constexpr action init_nonterminal(set<State...> state, set<Nonterminals...>,
-                                  set<States...>, set<Symbol>) noexcept {
+          typename... Rules, typename Symbol>
+constexpr action init_nonterminal(set<State...> state,
+                                  set<Nonterminals...> nonterminals,
+                                  set<States...>, set<Rules...> rules,
+                                  set<Symbol>) noexcept {
   if constexpr (!std::is_same<decltype(go_to(std::declval<Symbol>(), state)),
                               set<>>::value) {
-    return action{
-        action_type::Goto,
-        idx_from_prefix<0, decltype(go_to(std::declval<Symbol>(), state)),
-                        States...>()};
+    return action{action_type::Goto,
+                  idx_of<0, decltype(go_to_state<Symbol>(state, rules,
+                                                         nonterminals)),
+                         States...>()};
 
   } else {
     return {action_type::Unreachable};
@@ -519,6 +566,35 @@ reduce_rule(set<bullet_rule<Lhs, set<Seen...>, Rhs...>, Rules...>,
   return reduce_rule(set<Rules...>(), rules);
 }
 
+// Precedence of the rule that a state reduces.
+template <typename Lhs, typename... Seen, typename... Rhs, typename... Rules>
+constexpr size_t reduce_precedence(
+    set<bullet_rule<Lhs, set<Seen...>, Rhs...>, Rules...>) noexcept {
+  if constexpr (sizeof...(Rhs) == 0) {
+    return rhs_precedence<Seen...>();
+  } else {
+    return reduce_precedence(set<Rules...>());
+  }
+}
+
+constexpr size_t reduce_precedence(set<>) noexcept { return 0; }
+
+constexpr action resolve_conflict(action const &reduce, action const &shift,
+                                  size_t rule_level, size_t level,
+                                  associativity assoc) noexcept {
+  if (rule_level != level) {
+    return rule_level > level ? reduce : shift;
+  }
+  switch (assoc) {
+  case associativity::left:
+    return reduce;
+  case associativity::right:
+    return shift;
+  default:
+    return {action_type::Unreachable};
+  }
+}
+
 template <size_t AcceptIdx, typename... State, typename... AllSymbols,
           typename... States, typename... Rules>
 constexpr action init_reduce(set<State...> state, set<AllSymbols...>,
@@ -535,45 +611,55 @@ constexpr action init_reduce(set<State...> state, set<AllSymbols...>,
   }
 }
 
-template <typename... State, typename... States, typename Symbol>
+template <typename... State, typename... States, typename... Rules,
+          typename... Nonterminals, typename Symbol>
 constexpr action init_shift(set<State...> state, set<States...>,
+                            set<Rules...> rules,
+                            set<Nonterminals...> nonterminals,
                             set<Symbol>) noexcept {
   if constexpr (!std::is_same<decltype(go_to(std::declval<Symbol>(), state)),
                               set<>>::value) {
-    return action{
-        action_type::Shift,
-        idx_from_prefix<0, decltype(go_to(std::declval<Symbol>(), state)),
-                        States...>()};
+    return action{action_type::Shift,
+                  idx_of<0, decltype(go_to_state<Symbol>(state, rules,
+                                                         nonterminals)),
+                         States...>()};
   } else {
     return {action_type::Unreachable};
   }
 }
 
-template <typename... State, typename... Terminals>
-constexpr bool contains_shift(set<State...> state, set<Terminals...>) noexcept {
-  return ((!std::is_same<decltype(go_to(std::declval<Terminals>(), state)),
-                         set<>>::value) ||
-          ...);
-}
-
-template <
-    size_t AcceptIdx, typename... State, typename... AllSymbols,
-    typename... States, typename... Rules, typename Symbol,
-    typename std::enable_if<contains_reduce(set<State...>()), int>::type = 0>
+template <size_t AcceptIdx, typename... State, typename... AllSymbols,
+          typename... Nonterminals, typename... States, typename... Rules,
+          typename Symbol,
+          typename std::enable_if<contains_reduce(set<State...>()), int>::type =
+              0>
 constexpr action init_terminal(set<State...> state, set<AllSymbols...> symbols,
-                               set<States...>, set<Rules...> rules,
-                               set<Symbol>) noexcept {
-  return init_reduce<AcceptIdx>(state, symbols, rules);
+                               set<Nonterminals...> nonterminals,
+                               set<States...> states, set<Rules...> rules,
+                               set<Symbol> symbol) noexcept {
+  action reduce = init_reduce<AcceptIdx>(state, symbols, rules);
+  if constexpr (precedence_of<Symbol>() > 0 &&
+                reduce_precedence(set<State...>()) > 0) {
+    action shift = init_shift(state, states, rules, nonterminals, symbol);
+    if (shift.type == action_type::Shift) {
+      return resolve_conflict(reduce, shift, reduce_precedence(state),
+                              precedence_of<Symbol>(),
+                              Symbol::precedence_associativity);
+    }
+  }
+  return reduce;
 }
 
-template <
-    size_t AcceptIdx, typename... State, typename... AllSymbols,
-    typename... States, typename... Rules, typename Symbol,
-    typename std::enable_if<!contains_reduce(set<State...>()), int>::type = 0>
+template <size_t AcceptIdx, typename... State, typename... AllSymbols,
+          typename... Nonterminals, typename... States, typename... Rules,
+          typename Symbol,
+          typename std::enable_if<!contains_reduce(set<State...>()), int>::type =
+              0>
 constexpr action init_terminal(set<State...> state, set<AllSymbols...>,
-                               set<States...> states, set<Rules...>,
+                               set<Nonterminals...> nonterminals,
+                               set<States...> states, set<Rules...> rules,
                                set<Symbol> symbol) noexcept {
-  return init_shift(state, states, symbol);
+  return init_shift(state, states, rules, nonterminals, symbol);
 }
 
 template <size_t AcceptIdx, typename... State, typename... AllSymbols,
@@ -583,9 +669,9 @@ template <size_t AcceptIdx, typename... State, typename... AllSymbols,
                                   int>::type = 0>
 constexpr action init_action(set<State...> state, set<AllSymbols...>,
                              set<Nonterminals...> nonterminals,
-                             set<States...> states, set<Rules...>,
+                             set<States...> states, set<Rules...> rules,
                              set<Symbol> symbol) noexcept {
-  return init_nonterminal(state, nonterminals, states, symbol);
+  return init_nonterminal(state, nonterminals, states, rules, symbol);
 }
 
 template <size_t AcceptIdx, typename... State, typename... AllSymbols,
@@ -594,9 +680,11 @@ template <size_t AcceptIdx, typename... State, typename... AllSymbols,
           typename std::enable_if<!contains_t<Symbol, Nonterminals...>::value,
                                   int>::type = 0>
 constexpr action init_action(set<State...> state, set<AllSymbols...> symbols,
-                             set<Nonterminals...>, set<States...> states,
-                             set<Rules...> rules, set<Symbol> symbol) noexcept {
-  return init_terminal<AcceptIdx>(state, symbols, states, rules, symbol);
+                             set<Nonterminals...> nonterminals,
+                             set<States...> states, set<Rules...> rules,
+                             set<Symbol> symbol) noexcept {
+  return init_terminal<AcceptIdx>(state, symbols, nonterminals, states, rules,
+                                  symbol);
 }
 
 template <size_t AcceptIdx, typename... State, typename... AllSymbols,
@@ -621,15 +709,347 @@ constexpr auto init_rows(set<Start>, set<Rules...> rules, set<Nonterminals...>,
       set<AllStates...>(), rules)...};
 }
 
+// A state that reduces a unit rule `A -> X` does so on every terminal, and
+// then goes to `A` from the state below. A shift or goto into such a state
+// can therefore go to the target of `A` directly and apply `A(X&&)` to the
+// pushed value, skipping the reduce and goto. Chains of unit rules collapse
+// into one transition that applies all of their rules.
+template <typename Row, size_t NumStates>
+constexpr bool reduces_unit_rule(std::array<Row, NumStates> const &rows,
+                                 size_t state) noexcept {
+  action const &a = rows[state].actions[0];
+  if (a.type != action_type::Reduce || a.pop_nr != 1) {
+    return false;
+  }
+  // Precedence may have resolved some columns to shifts.
+  for (auto &other : rows[state].actions) {
+    if (other.type == action_type::Shift) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename Row, size_t NumStates>
+constexpr size_t unit_chain_length(std::array<Row, NumStates> const &rows,
+                                   size_t from, size_t state) noexcept {
+  size_t length = 0;
+  while (length < NumStates && reduces_unit_rule(rows, state)) {
+    state = rows[from].actions[rows[state].actions[0].idx].idx;
+    ++length;
+  }
+  return length;
+}
+
+template <typename Row, size_t NumStates>
+constexpr size_t
+num_unit_chain_rules(std::array<Row, NumStates> const &rows) noexcept {
+  size_t num = 0;
+  for (size_t from = 0; from < NumStates; ++from) {
+    for (auto &a : rows[from].actions) {
+      if (a.type == action_type::Shift || a.type == action_type::Goto) {
+        num += unit_chain_length(rows, from, a.idx);
+      }
+    }
+  }
+  return num;
+}
+
+// The distinct chains of unit rules of a table, innermost rule first. The
+// rules of chain `i` are `rules[offsets[i]]` up to `rules[offsets[i + 1]]`.
+template <size_t MaxRules> struct unit_chain_set {
+  std::array<size_t, MaxRules> rules{};
+  std::array<size_t, MaxRules + 1> offsets{};
+  size_t num_chains = 0;
+
+  // Index of the chain of the first `length` rules of `chain`, which is
+  // added unless an equal one exists.
+  template <size_t N>
+  constexpr size_t add(std::array<size_t, N> const &chain, size_t length) {
+    for (size_t i = 0; i < num_chains; ++i) {
+      size_t offset = offsets[i];
+      size_t j = 0;
+      while (j < length && offset + j < offsets[i + 1] &&
+             rules[offset + j] == chain[j]) {
+        ++j;
+      }
+      if (j == length && offset + j == offsets[i + 1]) {
+        return i;
+      }
+    }
+    for (size_t j = 0; j < length; ++j) {
+      rules[offsets[num_chains] + j] = chain[j];
+    }
+    offsets[num_chains + 1] = offsets[num_chains] + length;
+    return num_chains++;
+  }
+};
+
+// Returns the transitions with unit rules eliminated, and adds the chain of
+// rules that each of them applies to `chains`.
+template <typename Row, size_t NumStates, size_t MaxRules>
+constexpr std::array<Row, NumStates>
+eliminate_unit_rules(std::array<Row, NumStates> const &rows,
+                     unit_chain_set<MaxRules> &chains) noexcept {
+  std::array<Row, NumStates> result = rows;
+  for (size_t from = 0; from < NumStates; ++from) {
+    for (auto &a : result[from].actions) {
+      if (a.type != action_type::Shift && a.type != action_type::Goto) {
+        continue;
+      }
+      size_t length = unit_chain_length(rows, from, a.idx);
+      if (length == 0) {
+        continue;
+      }
+      std::array<size_t, NumStates> chain{};
+      for (size_t i = 0; i < length; ++i) {
+        action const &reduce = rows[a.idx].actions[0];
+        chain[i] = reduce.produce_fn;
+        a.idx = rows[from].actions[reduce.idx].idx;
+      }
+      a.pop_nr = length;
+      a.produce_fn = chains.add(chain, length);
+    }
+  }
+  return result;
+}
+
+template <size_t MaxRules, typename Row, size_t NumStates>
+constexpr unit_chain_set<MaxRules>
+collect_unit_chains(std::array<Row, NumStates> const &rows) noexcept {
+  unit_chain_set<MaxRules> chains;
+  eliminate_unit_rules(rows, chains);
+  return chains;
+}
+
+// Clears the rows of states that no shift or goto leads to anymore, like the
+// states that only reduced a unit rule, so they count as unused cells.
+template <typename Row, size_t NumStates>
+constexpr std::array<Row, NumStates>
+drop_unreachable(std::array<Row, NumStates> rows) noexcept {
+  std::array<bool, NumStates> reachable{};
+  std::array<size_t, NumStates> pending{};
+  size_t num_pending = 1;
+  reachable[0] = true;
+  while (num_pending > 0) {
+    for (auto &a : rows[pending[--num_pending]].actions) {
+      if ((a.type == action_type::Shift || a.type == action_type::Goto) &&
+          !reachable[a.idx]) {
+        reachable[a.idx] = true;
+        pending[num_pending++] = a.idx;
+      }
+    }
+  }
+  for (size_t state = 0; state < NumStates; ++state) {
+    if (!reachable[state]) {
+      rows[state] = Row{};
+    }
+  }
+  return rows;
+}
+
+template <size_t MaxRules, typename Row, size_t NumStates>
+constexpr std::array<Row, NumStates>
+unit_rows(std::array<Row, NumStates> const &rows) noexcept {
+  unit_chain_set<MaxRules> chains;
+  return drop_unreachable(eliminate_unit_rules(rows, chains));
+}
+
+// The first `N` elements of `values`.
+template <size_t N, size_t Size>
+constexpr std::array<size_t, N>
+take(std::array<size_t, Size> const &values) noexcept {
+  std::array<size_t, N> result{};
+  for (size_t i = 0; i < N; ++i) {
+    result[i] = values[i];
+  }
+  return result;
+}
+
+// The terminal columns of a table. A reduction's `idx` becomes the index of
+// its nonterminal in the goto table.
+template <typename Row, size_t NumStates, typename... Terminals>
+constexpr std::array<transition_table_row<Terminals...>, NumStates>
+terminal_columns(std::array<Row, NumStates> const &rows,
+                 set<Terminals...>) noexcept {
+  std::array<transition_table_row<Terminals...>, NumStates> result{};
+  for (size_t state = 0; state < NumStates; ++state) {
+    for (size_t terminal = 0; terminal < sizeof...(Terminals); ++terminal) {
+      action a = rows[state].actions[terminal];
+      if (a.type == action_type::Reduce) {
+        a.idx -= sizeof...(Terminals);
+      }
+      result[state].actions[terminal] = a;
+    }
+  }
+  return result;
+}
+
+// The nonterminal columns of a table, indexed by nonterminal and then state.
+// Every reduction looks up the goto of one nonterminal from whichever state
+// it uncovers.
+template <size_t NumTerminals, size_t NumNonterminals, typename Row,
+          size_t NumStates>
+constexpr std::array<std::array<action, NumStates>, NumNonterminals>
+goto_columns(std::array<Row, NumStates> const &rows) noexcept {
+  std::array<std::array<action, NumStates>, NumNonterminals> result{};
+  for (size_t nonterminal = 0; nonterminal < NumNonterminals; ++nonterminal) {
+    for (size_t state = 0; state < NumStates; ++state) {
+      result[nonterminal][state] =
+          rows[state].actions[NumTerminals + nonterminal];
+    }
+  }
+  return result;
+}
+
+// Layouts of a table. `discovery_order` numbers the states in the order they
+// are found, and the columns in the order of the symbol sets.
+struct discovery_order {};
+
+// Numbers the states and columns by the lookups that an `instrumentation`
+// run recorded, see `parse_stats::write_profile`, the most frequent first.
+// The rows and cells that real traffic touches then share cache lines. The
+// start state keeps the number 0.
+template <typename Profile> struct profile_guided {};
+
+// Takes the tables that `write_tables` generated for a grammar, see
+// table_report.hpp, instead of constructing its automaton again. `Tables`
+// holds the rows as they were in the layout they were generated with.
+template <typename Tables> struct precompiled {};
+
+// Indices `[0, N)` by descending `hits[Offset + i]`, ties by index. With
+// `PinFirst`, index 0 stays in front.
+template <size_t N, size_t Offset, bool PinFirst, typename Hits>
+constexpr std::array<size_t, N> hot_first(Hits const &hits) noexcept {
+  std::array<size_t, N> order{};
+  for (size_t i = 0; i < N; ++i) {
+    order[i] = i;
+  }
+  size_t const first = PinFirst ? 1 : 0;
+  for (size_t i = first + 1; i < N; ++i) {
+    for (size_t j = i;
+         j > first && hits[Offset + order[j - 1]] < hits[Offset + order[j]];
+         --j) {
+      std::swap(order[j - 1], order[j]);
+    }
+  }
+  return order;
+}
+
+template <size_t NumStates>
+constexpr std::array<size_t, NumStates>
+layout_states(discovery_order) noexcept {
+  return hot_first<NumStates, 0, true>(std::array<uint64_t, NumStates>{});
+}
+
+template <size_t NumStates, typename Profile>
+constexpr std::array<size_t, NumStates>
+layout_states(profile_guided<Profile>) noexcept {
+  static_assert(Profile::states.size() == NumStates,
+                "Profile was recorded for another grammar");
+  return hot_first<NumStates, 0, true>(Profile::states);
+}
+
+// Order of the `Num` columns that start at `Offset` among all symbols.
+template <size_t Num, size_t Offset, size_t NumSymbols>
+constexpr std::array<size_t, Num> layout_columns(discovery_order) noexcept {
+  return hot_first<Num, 0, false>(std::array<uint64_t, Num>{});
+}
+
+template <size_t Num, size_t Offset, size_t NumSymbols, typename Profile>
+constexpr std::array<size_t, Num>
+layout_columns(profile_guided<Profile>) noexcept {
+  static_assert(Profile::symbols.size() == NumSymbols,
+                "Profile was recorded for another grammar");
+  return hot_first<Num, Offset, false>(Profile::symbols);
+}
+
+// Position of every index in `order`.
+template <size_t N>
+constexpr std::array<size_t, N>
+positions_of(std::array<size_t, N> const &order) noexcept {
+  std::array<size_t, N> result{};
+  for (size_t i = 0; i < N; ++i) {
+    result[order[i]] = i;
+  }
+  return result;
+}
+
+// Renumbers the states and nonterminals that an action refers to.
+template <size_t NumStates, size_t NumNonterminals>
+constexpr action
+renumber(action a, std::array<size_t, NumStates> const &state_positions,
+         std::array<size_t, NumNonterminals> const &nonterminal_positions) {
+  if (a.type == action_type::Shift || a.type == action_type::Goto) {
+    a.idx = state_positions[a.idx];
+  } else if (a.type == action_type::Reduce) {
+    a.idx = nonterminal_positions[a.idx];
+  }
+  return a;
+}
+
+// The terminal columns in the order of a layout, with `states[i]` becoming
+// state `i` and `terminals[i]` column `i`.
+template <typename Row, size_t NumStates, size_t NumTerminals,
+          size_t NumNonterminals>
+constexpr std::array<Row, NumStates>
+arrange_rows(std::array<Row, NumStates> const &rows,
+             std::array<size_t, NumStates> const &states,
+             std::array<size_t, NumTerminals> const &terminals,
+             std::array<size_t, NumNonterminals> const &nonterminals) noexcept {
+  auto state_positions = positions_of(states);
+  auto nonterminal_positions = positions_of(nonterminals);
+  std::array<Row, NumStates> result{};
+  for (size_t state = 0; state < NumStates; ++state) {
+    for (size_t terminal = 0; terminal < NumTerminals; ++terminal) {
+      result[state].actions[terminal] =
+          renumber(rows[states[state]].actions[terminals[terminal]],
+                   state_positions, nonterminal_positions);
+    }
+  }
+  return result;
+}
+
+template <size_t NumStates, size_t NumNonterminals>
+constexpr std::array<std::array<action, NumStates>, NumNonterminals>
+arrange_gotos(
+    std::array<std::array<action, NumStates>, NumNonterminals> const &gotos,
+    std::array<size_t, NumStates> const &states,
+    std::array<size_t, NumNonterminals> const &nonterminals) noexcept {
+  auto state_positions = positions_of(states);
+  auto nonterminal_positions = positions_of(nonterminals);
+  std::array<std::array<action, NumStates>, NumNonterminals> result{};
+  for (size_t nonterminal = 0; nonterminal < NumNonterminals; ++nonterminal) {
+    for (size_t state = 0; state < NumStates; ++state) {
+      result[nonterminal][state] =
+          renumber(gotos[nonterminals[nonterminal]][states[state]],
+                   state_positions, nonterminal_positions);
+    }
+  }
+  return result;
+}
+
 template <typename... States>
 constexpr bool reduce_reduce_conflict(set<States...>) noexcept {
   return ((num_reduces(States()) > 1) || ...);
 }
 
+// Whether a state shifts a terminal without precedence over its reduction.
+template <typename... State, typename... Terminals>
+constexpr bool contains_unresolved_shift(set<State...> state,
+                                         set<Terminals...>) noexcept {
+  return ((!std::is_same<decltype(go_to(std::declval<Terminals>(), state)),
+                         set<>>::value &&
+           (precedence_of<Terminals>() == 0 ||
+            reduce_precedence(state) == 0)) ||
+          ...);
+}
+
 template <typename... States, typename... Terminals>
 constexpr bool shift_reduce_conflict(set<States...>,
                                      set<Terminals...> terminals) noexcept {
-  return ((contains_reduce(States()) && contains_shift(States(), terminals)) ||
+  return ((contains_reduce(States()) &&
+           contains_unresolved_shift(States(), terminals)) ||
           ...);
 }
 
@@ -638,10 +1058,6 @@ constexpr bool has_conflict(set<States...> states, set<Terminals...> terminals)
   return reduce_reduce_conflict(states) || shift_reduce_conflict(states, terminals);
 }
 
-struct symbol {
-  virtual ~symbol() {}
-};
-
 template <typename... Symbols> constexpr bool all_symbols() {
   return (std::is_base_of<symbol, Symbols>::value && ...);
 }
@@ -651,25 +1067,33 @@ template <typename... Symbols> constexpr bool all_symbols(set<Symbols...>) {
 }
 
 template <typename Lhs, typename... Rhs>
-constexpr void eval_nonterminal(std::vector<symbol *> &symbols) {
+constexpr void eval_nonterminal(std::vector<symbol *> &symbols,
+                                symbol_arena &arena) {
   auto args_iter = symbols.end() - sizeof...(Rhs);
-  Lhs *nonterminal =
-      new Lhs{(std::move(*dynamic_cast<Rhs *>(*args_iter++)))...};
+  std::tuple<Rhs *...> args{dynamic_cast<Rhs *>(*args_iter++)...};
+  Lhs *nonterminal = std::apply(
+      [&arena](Rhs *... rhs) { return arena.make<Lhs>(std::move(*rhs)...); },
+      args);
   symbols.erase(symbols.end() - sizeof...(Rhs), symbols.end());
   symbols.push_back(nonterminal);
 }
 
+// The arguments are popped instead of erased, so symbols only have to be
+// move constructible, not assignable.
 template <typename Symbols, typename Lhs, typename... Rhs>
 constexpr void eval_nonterminal(std::vector<Symbols> &symbols) {
   auto args_iter = symbols.end() - sizeof...(Rhs);
   Lhs nonterminal{(std::move(std::get<Rhs>(*args_iter++)))...};
-  symbols.erase(symbols.end() - sizeof...(Rhs), symbols.end());
+  for (size_t i = 0; i < sizeof...(Rhs); ++i) {
+    symbols.pop_back();
+  }
   symbols.emplace_back(std::move(nonterminal));
 }
 
 template <typename... Symbols,
           typename std::enable_if<all_symbols<Symbols...>(), int>::type = 0>
-constexpr auto eval_nonterminal_fn() -> void (*)(std::vector<symbol *> &);
+constexpr auto eval_nonterminal_fn()
+    -> void (*)(std::vector<symbol *> &, symbol_arena &);
 
 template <typename... Symbols,
           typename std::enable_if<!all_symbols<Symbols...>(), int>::type = 0>
@@ -702,6 +1126,81 @@ init_eval_fns(set<Rules...>, set<Symbols...> symbols) noexcept {
   return {init_eval_fn(Rules(), symbols)...};
 }
 
+template <typename Lhs, typename Rhs>
+constexpr auto unit_rhs(rule<Lhs, Rhs>) noexcept -> Rhs;
+
+// Applies a chain of unit rules, outermost first, to `value` in one nested
+// constructor call, so the values between its rules are temporaries.
+template <typename Value> constexpr Value &&apply_unit_rules(Value &value) {
+  return std::move(value);
+}
+
+template <typename Value, typename Lhs, typename Rhs, typename... Inner>
+constexpr Lhs apply_unit_rules(Value &value, rule<Lhs, Rhs>, Inner... inner) {
+  return Lhs{apply_unit_rules(value, inner...)};
+}
+
+// Replaces the `Value` on top of the stack by the `Lhs` of a unit chain,
+// with one arena slot for the result instead of one per rule.
+template <typename Value, typename Lhs, typename... Inner>
+constexpr void eval_unit_chain(std::vector<symbol *> &symbols,
+                               symbol_arena &arena) {
+  Value &value = *dynamic_cast<Value *>(symbols.back());
+  symbols.back() = arena.make<Lhs>(apply_unit_rules(value, Inner()...));
+}
+
+template <typename Symbols, typename Value, typename Lhs, typename... Inner>
+constexpr void eval_unit_chain(std::vector<Symbols> &symbols) {
+  Lhs nonterminal{apply_unit_rules(std::get<Value>(symbols.back()),
+                                   Inner()...)};
+  symbols.pop_back();
+  symbols.emplace_back(std::move(nonterminal));
+}
+
+template <typename Value, typename... Symbols, typename Lhs, typename Rhs,
+          typename... Inner,
+          typename std::enable_if<all_symbols<Symbols...>(), int>::type = 0>
+constexpr eval_fn<Symbols...> init_unit_chain_fn(set<Symbols...>,
+                                                 rule<Lhs, Rhs>,
+                                                 Inner...) noexcept {
+  return &eval_unit_chain<Value, Lhs, Inner...>;
+}
+
+template <typename Value, typename... Symbols, typename Lhs, typename Rhs,
+          typename... Inner,
+          typename std::enable_if<!all_symbols<Symbols...>(), int>::type = 0>
+constexpr eval_fn<Symbols...> init_unit_chain_fn(set<Symbols...>,
+                                                 rule<Lhs, Rhs>,
+                                                 Inner...) noexcept {
+  return &eval_unit_chain<std::variant<Symbols...>, Value, Lhs, Inner...>;
+}
+
+// The composed evaluation of chain `Chain` of `Data::unit_chains`, whose
+// rules are in `Data::chain_offsets[Chain]` up to the next offset.
+template <typename Data, size_t Chain, typename... Rules, typename... Symbols,
+          size_t... Steps>
+constexpr eval_fn<Symbols...>
+init_unit_chain_fn(set<Rules...> rules, set<Symbols...> symbols,
+                   std::index_sequence<Steps...>) noexcept {
+  constexpr size_t first = Data::chain_offsets[Chain];
+  constexpr size_t last = Data::chain_offsets[Chain + 1] - 1;
+  return init_unit_chain_fn<decltype(unit_rhs(
+      get_element<Data::unit_chains[first]>(rules)))>(
+      symbols, decltype(get_element<Data::unit_chains[last - Steps]>(
+                   rules))()...);
+}
+
+template <typename Data, typename... Rules, typename... Symbols,
+          size_t... Chains>
+constexpr std::array<eval_fn<Symbols...>, sizeof...(Chains)>
+init_unit_chain_fns(set<Rules...> rules, set<Symbols...> symbols,
+                    std::index_sequence<Chains...>) noexcept {
+  return {init_unit_chain_fn<Data, Chains>(
+      rules, symbols,
+      std::make_index_sequence<Data::chain_offsets[Chains + 1] -
+                               Data::chain_offsets[Chains]>())...};
+}
+
 template <typename... Symbols,
           typename std::enable_if<all_symbols<Symbols...>(), int>::type = 0>
 constexpr auto value_stack(set<Symbols...>) -> std::vector<symbol *>;
@@ -711,61 +1210,602 @@ template <typename... Symbols,
 constexpr auto value_stack(set<Symbols...>)
     -> std::vector<std::variant<Symbols...>>;
 
+template <typename... Symbols,
+          typename std::enable_if<all_symbols<Symbols...>(), int>::type = 0>
+constexpr auto value_arena(set<Symbols...>) -> symbol_arena;
+
+template <typename... Symbols,
+          typename std::enable_if<!all_symbols<Symbols...>(), int>::type = 0>
+constexpr auto value_arena(set<Symbols...>) -> no_arena;
+
+template <typename Symbol> Symbol &get_symbol(symbol *value) {
+  return *dynamic_cast<Symbol *>(value);
+}
+
+template <typename Symbol, typename... Symbols>
+Symbol &get_symbol(std::variant<Symbols...> &value) {
+  return std::get<Symbol>(value);
+}
+
+enum class read_status {
+  shifted,
+  accepted,
+  floor_reached,
+  discarded,
+};
+
+template <typename Handler, typename Lhs, typename... Rhs>
+void reduce_event(Handler &handler) {
+  handler.reduce(rule<Lhs, Rhs...>());
+}
+
+template <typename Handler, typename Lhs, typename... Rhs>
+constexpr auto event_fn(rule<Lhs, Rhs...>) noexcept -> void (*)(Handler &) {
+  return &reduce_event<Handler, Lhs, Rhs...>;
+}
+
+template <typename Handler, typename... Rules>
+constexpr std::array<void (*)(Handler &), sizeof...(Rules)>
+init_event_fns(set<Rules...>) noexcept {
+  return {event_fn<Handler>(Rules())...};
+}
+
+// Semantics of a `transition_table`: `build_values` evaluates every rule into
+// a value stack, `events` only reports shifts and reductions to a handler.
+struct build_values {};
+
+template <typename Handler> struct events {};
+
+// `recognize` only runs the state machine over token kinds, without values.
+struct recognize {};
+
+// Payload free stand-in for a token, for scanners feeding a recognizer.
+template <typename Token> struct kind {};
+
+// Terminal that stands for a stretch of invalid input. A grammar that lists
+// `error` among its terminals recovers like yacc: on an invalid token the
+// table pops states until one can shift `error`, shifts it, and then skips
+// tokens until one is valid again. Lexers may also emit `error` themselves.
+struct error : symbol {};
+
+struct diagnostic {
+  size_t offset = 0;
+  size_t state = 0;
+  size_t terminal = 0;
+};
+
+// Recovery state of a table whose grammar has an `error` terminal. Keeps the
+// first `limit` diagnostics and counts all of them. Drivers set `position`
+// to the offset of each token before reading it. Like yacc, errors are not
+// reported until `quiet_tokens` tokens have been shifted after `error`, so
+// one mistake is reported once.
+struct error_recovery {
+  static constexpr size_t quiet_tokens = 3;
+
+  std::vector<diagnostic> entries;
+  size_t limit = 64;
+  size_t total = 0;
+  size_t position = 0;
+  // Tokens left to shift before errors are reported again.
+  size_t quiet = 0;
+
+  constexpr void report(size_t state, size_t terminal) {
+    if (quiet > 0) {
+      return;
+    }
+    ++total;
+    if (entries.size() < limit) {
+      entries.push_back({position, state, terminal});
+    }
+  }
+
+  constexpr void reset() noexcept {
+    entries.clear();
+    total = 0;
+    position = 0;
+    quiet = 0;
+  }
+};
+
+struct no_recovery {
+  constexpr void reset() noexcept {}
+};
+
+template <typename... Terminals>
+constexpr size_t error_column(set<Terminals...>) noexcept {
+  if constexpr (contains_t<error, Terminals...>::value) {
+    return idx_of<0, error, Terminals...>();
+  } else {
+    return sizeof...(Terminals);
+  }
+}
+
+// Size of a parse table, for reports and compile time budgets.
+struct table_stats {
+  size_t num_states = 0;
+  size_t num_terminals = 0;
+  size_t num_nonterminals = 0;
+  size_t num_rules = 0;
+  size_t table_bytes = 0;
+  size_t num_cells = 0;
+  size_t used_cells = 0;
+  size_t max_rhs = 0;
+  bool has_conflict = false;
+
+  friend constexpr bool operator==(table_stats const &,
+                                   table_stats const &) = default;
+
+  constexpr double density() const noexcept {
+    return num_cells > 0 ? static_cast<double>(used_cells) / num_cells : 0;
+  }
+
+  friend std::ostream &operator<<(std::ostream &stream,
+                                  table_stats const &stats) {
+    stream << "states:       " << stats.num_states << '\n'
+           << "terminals:    " << stats.num_terminals << '\n'
+           << "nonterminals: " << stats.num_nonterminals << '\n'
+           << "rules:        " << stats.num_rules << '\n'
+           << "table bytes:  " << stats.table_bytes << '\n'
+           << "used cells:   " << stats.used_cells << " / " << stats.num_cells
+           << " (" << 100 * stats.density() << "%)\n"
+           << "max rhs:      " << stats.max_rhs << '\n'
+           << "conflicts:    " << (stats.has_conflict ? "yes" : "no") << '\n';
+    return stream;
+  }
+};
+
+// Upper bounds on `table_stats`, e.g.
+// `static_assert(within(table::stats(), {.max_bytes = 32 * 1024}));`
+struct table_budget {
+  size_t max_bytes = std::numeric_limits<size_t>::max();
+  size_t max_states = std::numeric_limits<size_t>::max();
+  size_t max_rhs = std::numeric_limits<size_t>::max();
+  bool allow_conflicts = false;
+};
+
+constexpr bool within(table_stats const &stats,
+                      table_budget const &budget) noexcept {
+  return stats.table_bytes <= budget.max_bytes &&
+         stats.num_states <= budget.max_states &&
+         stats.max_rhs <= budget.max_rhs &&
+         (budget.allow_conflicts || !stats.has_conflict);
+}
+
+// Automaton of a grammar in a `Layout`: the action rows, gotos and unit rule
+// chains, and the order of its states and columns. Constructing `states` is
+// the expensive part of compiling a grammar.
 template <typename Start, typename Rules, typename Nonterminals,
-          typename Terminals>
-struct transition_table {
+          typename Terminals, typename Layout>
+struct table_data {
   using rules = decltype(to_bullet_rules(Rules()));
   using states = decltype(
       make_states(std::declval<Start>(), rules(), Nonterminals(), Terminals()));
   using symbols = decltype(join(Terminals(), Nonterminals()));
 
-  const std::array<decltype(make_row(Terminals(), Nonterminals())),
-                   states::num_elements>
-      rows = init_rows(set<Start>(), rules(), Nonterminals(), Terminals(),
-                       states());
+  static constexpr size_t num_states = states::num_elements;
+
+  static constexpr std::array<decltype(make_row(Terminals(), Nonterminals())),
+                              num_states>
+      lr0_rows = init_rows(set<Start>(), rules(), Nonterminals(), Terminals(),
+                           states());
+
+  static constexpr size_t max_chain_rules = num_unit_chain_rules(lr0_rows);
+
+  static constexpr unit_chain_set<max_chain_rules> chains =
+      collect_unit_chains<max_chain_rules>(lr0_rows);
+
+  // The rules of every distinct unit chain, see `unit_chain_set`.
+  static constexpr std::array<size_t, chains.offsets[chains.num_chains]>
+      unit_chains = take<chains.offsets[chains.num_chains]>(chains.rules);
+  static constexpr std::array<size_t, chains.num_chains + 1> chain_offsets =
+      take<chains.num_chains + 1>(chains.offsets);
+
+  static constexpr std::array<decltype(make_row(Terminals(), Nonterminals())),
+                              num_states>
+      unit_free_rows = unit_rows<max_chain_rules>(lr0_rows);
+
+  // Discovery order number of every state, terminal column and nonterminal
+  // column of the `Layout`.
+  static constexpr std::array<size_t, num_states> state_order =
+      layout_states<num_states>(Layout());
+  static constexpr std::array<size_t, Terminals::num_elements> terminal_order =
+      layout_columns<Terminals::num_elements, 0, symbols::num_elements>(
+          Layout());
+  static constexpr std::array<size_t, Nonterminals::num_elements>
+      nonterminal_order =
+          layout_columns<Nonterminals::num_elements, Terminals::num_elements,
+                         symbols::num_elements>(Layout());
+
+  // Shifts, reductions and accepts by state and terminal. The tables are
+  // shared by all parsers of a grammar, a parser object only holds its
+  // mutable state.
+  static constexpr std::array<decltype(make_row(Terminals(), set<>())),
+                              num_states>
+      rows = arrange_rows(terminal_columns(unit_free_rows, Terminals()),
+                          state_order, terminal_order, nonterminal_order);
+
+  // Gotos by nonterminal and state.
+  static constexpr std::array<std::array<action, num_states>,
+                              Nonterminals::num_elements>
+      gotos = arrange_gotos(
+          goto_columns<Terminals::num_elements, Nonterminals::num_elements>(
+              unit_free_rows),
+          state_order, nonterminal_order);
+
+  static constexpr table_stats stats() noexcept {
+    table_stats result{num_states,
+                       Terminals::num_elements,
+                       Nonterminals::num_elements,
+                       rules::num_elements,
+                       sizeof(rows) + sizeof(gotos),
+                       num_states * symbols::num_elements,
+                       0,
+                       max_sizeof_rhs(rules()),
+                       has_conflict(states(), Terminals())};
+    for (auto &row : rows) {
+      for (auto &a : row.actions) {
+        result.used_cells += a.type != action_type::Unreachable;
+      }
+    }
+    for (auto &column : gotos) {
+      for (auto &a : column) {
+        result.used_cells += a.type != action_type::Unreachable;
+      }
+    }
+    return result;
+  }
+};
+
+// Rows of type `Row` with the actions of `actions`.
+template <typename Row, size_t NumStates, size_t NumTerminals>
+constexpr std::array<Row, NumStates>
+to_rows(std::array<std::array<action, NumTerminals>, NumStates> const
+            &actions) noexcept {
+  std::array<Row, NumStates> result{};
+  for (size_t state = 0; state < NumStates; ++state) {
+    result[state].actions = actions[state];
+  }
+  return result;
+}
+
+// Takes the automaton from the plain arrays of `Tables` instead. Only the
+// sizes are checked against the grammar, so one translation unit should
+// compare them with a computed table, see `same_tables`.
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Tables>
+struct table_data<Start, Rules, Nonterminals, Terminals, precompiled<Tables>> {
+  using rules = decltype(to_bullet_rules(Rules()));
+
+  static_assert(Tables::terminal_order.size() == Terminals::num_elements &&
+                    Tables::nonterminal_order.size() ==
+                        Nonterminals::num_elements &&
+                    Tables::stats.num_rules == rules::num_elements,
+                "Tables were generated for another grammar");
+
+  static constexpr size_t num_states = Tables::state_order.size();
+  static constexpr auto unit_chains = Tables::unit_chains;
+  static constexpr auto chain_offsets = Tables::chain_offsets;
+  static constexpr auto state_order = Tables::state_order;
+  static constexpr auto terminal_order = Tables::terminal_order;
+  static constexpr auto nonterminal_order = Tables::nonterminal_order;
+  static constexpr std::array<decltype(make_row(Terminals(), set<>())),
+                              num_states>
+      rows = to_rows<decltype(make_row(Terminals(), set<>()))>(
+          Tables::actions);
+  static constexpr auto gotos = Tables::gotos;
+
+  static constexpr table_stats stats() noexcept { return Tables::stats; }
+};
+
+// Whether two tables of a grammar have the same automaton and layout, e.g.
+// precompiled tables and the ones they were generated from.
+template <typename Table, typename Other> constexpr bool same_tables() {
+  if constexpr (Table::num_states != Other::num_states ||
+                Table::unit_chains.size() != Other::unit_chains.size() ||
+                Table::chain_offsets.size() != Other::chain_offsets.size()) {
+    return false;
+  } else {
+    return Table::stats() == Other::stats() && Table::rows == Other::rows &&
+           Table::gotos == Other::gotos &&
+           Table::unit_chains == Other::unit_chains &&
+           Table::chain_offsets == Other::chain_offsets &&
+           Table::state_order == Other::state_order &&
+           Table::terminal_order == Other::terminal_order &&
+           Table::nonterminal_order == Other::nonterminal_order;
+  }
+}
+
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Instrumentation = no_instrumentation,
+          typename Layout = discovery_order>
+struct parse_table
+    : table_data<Start, Rules, Nonterminals, Terminals, Layout> {
+  using data = table_data<Start, Rules, Nonterminals, Terminals, Layout>;
+  using typename data::rules;
+  using data::gotos;
+  using data::nonterminal_order;
+  using data::num_states;
+  using data::rows;
+  using data::state_order;
+  using data::terminal_order;
+  using symbols = decltype(join(Terminals(), Nonterminals()));
+  using counters = typename Instrumentation::template counters<
+      set<Start, Rules, Nonterminals, Terminals>, rules::num_elements,
+      num_states, symbols::num_elements>;
+
+  // The column of every terminal and nonterminal.
+  static constexpr std::array<size_t, Terminals::num_elements>
+      terminal_positions = positions_of(terminal_order);
+  static constexpr std::array<size_t, Nonterminals::num_elements>
+      nonterminal_positions = positions_of(nonterminal_order);
+
+  static constexpr bool recovers =
+      error_column(Terminals()) < Terminals::num_elements;
+  static constexpr size_t error_idx =
+      recovers ? terminal_positions[error_column(Terminals())]
+               : Terminals::num_elements;
+
+  // Column of a terminal in `rows`.
+  template <typename Token> static constexpr size_t column() noexcept {
+    return terminal_positions[idx_of<Token>(Terminals())];
+  }
+
+  template <typename Token>
+  static constexpr size_t column(Token const &) noexcept {
+    return column<Token>();
+  }
+
+  std::vector<size_t> stack{0};
+  [[no_unique_address]]
+  typename if_t<recovers, error_recovery, no_recovery>::type recovery;
+
+  constexpr void reset() noexcept {
+    stack.resize(1);
+    stack[0] = 0;
+    recovery.reset();
+  }
+
+  // Reports an invalid token, unless it is an `error` from the lexer or an
+  // earlier error is still recovering, and pops states until one can shift
+  // `error`, calling `pop` for each. Throws if that would pop below `floor`
+  // states. Returns the shift of `error`.
+  template <typename Pop>
+  constexpr action const &recover(size_t terminal_idx, size_t floor,
+                                  Pop &&pop) {
+    if (terminal_idx != error_idx) {
+      recovery.report(stack.back(), terminal_idx);
+    }
+    while (rows[stack.back()].actions[error_idx].type != action_type::Shift) {
+      if (stack.size() <= floor) {
+        throw std::runtime_error("Invalid input token");
+      }
+      stack.pop_back();
+      pop();
+    }
+    recovery.quiet = error_recovery::quiet_tokens;
+    return rows[stack.back()].actions[error_idx];
+  }
+
+  // Whether an invalid token is skipped because no token has been shifted
+  // since the last `error`.
+  constexpr bool skips(size_t terminal_idx) const noexcept {
+    if constexpr (recovers) {
+      return recovery.quiet == error_recovery::quiet_tokens &&
+             terminal_idx != error_idx;
+    } else {
+      return false;
+    }
+  }
+
+  // Counts a shift towards the end of a recovery, or starts one if the
+  // lexer's `error` was shifted.
+  constexpr void shifted(size_t terminal_idx) noexcept {
+    if constexpr (recovers) {
+      if (terminal_idx == error_idx) {
+        recovery.quiet = error_recovery::quiet_tokens;
+      } else if (recovery.quiet > 0) {
+        --recovery.quiet;
+      }
+    }
+  }
+
+  // Pushes the goto of `nonterminal` from the uncovered state, and returns
+  // it for the unit rules it applies.
+  constexpr action const &push_goto(size_t nonterminal) {
+    counters::lookup(state_order[stack.back()],
+                     Terminals::num_elements + nonterminal_order[nonterminal]);
+    action const &next = gotos[nonterminal][stack.back()];
+    stack.push_back(next.idx);
+    counters::go_to();
+    counters::stack_depth(stack.size());
+    return next;
+  }
+
+  // Counts a lookup of `column` in the current state, by discovery order,
+  // so that a profile fits every layout.
+  constexpr void count_lookup(size_t column) const noexcept {
+    counters::lookup(state_order[stack.back()], terminal_order[column]);
+  }
+
+  // Counters of all threads parsing this grammar, only available with the
+  // `instrumentation` policy.
+  static auto statistics() { return counters::snapshot(); }
+
+  friend std::ostream &operator<<(std::ostream &stream,
+                                  parse_table const &table) {
+    for (size_t state = 0; state < table.rows.size(); ++state) {
+      stream << table.rows[state];
+      for (auto &column : table.gotos) {
+        stream << column[state] << ' ';
+      }
+      stream << '\n';
+    }
+    stream << '\n';
+    return stream;
+  }
+};
 
-  const std::array<decltype(make_eval_fn(symbols())), rules::num_elements>
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Semantics = build_values,
+          typename Instrumentation = no_instrumentation,
+          typename Layout = discovery_order>
+struct transition_table : parse_table<Start, Rules, Nonterminals, Terminals,
+                                      Instrumentation, Layout> {
+  using base = parse_table<Start, Rules, Nonterminals, Terminals,
+                           Instrumentation, Layout>;
+  using typename base::counters;
+  using typename base::rules;
+  using typename base::symbols;
+  using base::rows;
+  using base::stack;
+  using base::state_order;
+
+  static constexpr std::array<decltype(make_eval_fn(symbols())),
+                              rules::num_elements>
       eval_functions =
           init_eval_fns(Rules(), join(Terminals(), Nonterminals()));
 
-  std::vector<size_t> stack{0};
-  decltype(value_stack(symbols())) values{0};
+  // One function per distinct unit chain, by the `produce_fn` of the shifts
+  // and gotos that apply it.
+  static constexpr std::array<decltype(make_eval_fn(symbols())),
+                              base::chain_offsets.size() - 1>
+      unit_chain_functions = init_unit_chain_fns<base>(
+          Rules(), join(Terminals(), Nonterminals()),
+          std::make_index_sequence<base::chain_offsets.size() - 1>());
 
-  template <typename Token> bool read_token(Token &&token) {
-    size_t action_idx = idx_of(token, Terminals());
+  using value_type = typename decltype(value_stack(symbols()))::value_type;
+
+  std::vector<value_type> values;
+  decltype(value_arena(symbols())) arena;
+
+  constexpr void reset() noexcept {
+    base::reset();
+    values.clear();
+    arena.reset();
+  }
+
+  constexpr void eval(size_t rule_idx) {
+    if constexpr (all_symbols(symbols())) {
+      (eval_functions[rule_idx])(values, arena);
+    } else {
+      (eval_functions[rule_idx])(values);
+    }
+  }
+
+  template <typename Symbol> constexpr void push_value(Symbol &&symbol) {
+    if constexpr (all_symbols(symbols())) {
+      values.emplace_back(arena.template make<Symbol>(std::move(symbol)));
+    } else {
+      values.emplace_back(std::move(symbol));
+    }
+  }
+
+  // Applies the unit rules that were folded into a shift or goto.
+  constexpr void eval_unit_rules(action const &act) {
+    if (act.pop_nr == 0) {
+      return;
+    }
+    if constexpr (all_symbols(symbols())) {
+      (unit_chain_functions[act.produce_fn])(values, arena);
+    } else {
+      (unit_chain_functions[act.produce_fn])(values);
+    }
+    size_t first = base::chain_offsets[act.produce_fn];
+    for (size_t i = first; i < first + act.pop_nr; ++i) {
+      counters::reduce(base::unit_chains[i]);
+    }
+  }
+
+  template <typename Token> constexpr bool read_token(Token &&token) {
+    return read_token_above(std::move(token), 1) == read_status::accepted;
+  }
+
+  // Like `read_token`, but stops before a reduction would pop the stack below
+  // `floor` states and leaves the token unconsumed. This parses a segment of
+  // the input on top of a stack prefix that belongs to someone else.
+  template <typename Token>
+  constexpr read_status read_token_above(Token &&token, size_t floor) {
+    size_t const terminal_idx = base::column(token);
     while (true) {
-      action const &act = rows[stack.back()].actions[action_idx];
+      base::count_lookup(terminal_idx);
+      action const &act = rows[stack.back()].actions[terminal_idx];
       switch (act.type) {
       case action_type::Shift:
         stack.push_back(act.idx);
-        if constexpr (all_symbols(symbols())) {
-          values.emplace_back(new Token(std::move(token)));
-        } else {
-          values.emplace_back(std::move(token));
-        }
-        return false;
+        push_value(std::move(token));
+        eval_unit_rules(act);
+        base::shifted(terminal_idx);
+        counters::shift();
+        counters::stack_depth(stack.size());
+        counters::values(values.size());
+        return read_status::shifted;
       case action_type::Reduce: {
-        (eval_functions[act.produce_fn])(values);
-        stack.erase(stack.end() - act.pop_nr, stack.end());
-        action_idx = act.idx;
-        continue;
-      }
-      case action_type::Goto: {
-        stack.push_back(act.idx);
-        action_idx = idx_of(token, Terminals());
+        if (stack.size() - act.pop_nr < floor) {
+          return read_status::floor_reached;
+        }
+        eval(act.produce_fn);
+        counters::reduce(act.produce_fn);
+        stack.resize(stack.size() - act.pop_nr);
+        eval_unit_rules(base::push_goto(act.idx));
+        counters::values(values.size());
         continue;
       }
       case action_type::Accept:
-        return true;
+        return read_status::accepted;
       default:
+        counters::error(state_order[stack.back()]);
+        if constexpr (base::recovers) {
+          if (base::skips(terminal_idx)) {
+            return read_status::discarded;
+          }
+          action const &shift = base::recover(terminal_idx, floor,
+                                              [this] { values.pop_back(); });
+          stack.push_back(shift.idx);
+          push_value(error());
+          eval_unit_rules(shift);
+          if (terminal_idx == base::error_idx) {
+            return read_status::shifted;
+          }
+          continue;
+        }
         throw std::runtime_error("Invalid input token");
       }
     }
   }
 
-  Start const &get_parse_result() {
+  // Pushes a symbol that was constructed elsewhere, e.g. a nonterminal parsed
+  // by another table, as if it had just been shifted or reduced.
+  template <typename Symbol> void read_symbol(Symbol &&symbol) {
+    action const *next = nullptr;
+    if constexpr (has_element<std::decay_t<Symbol>>(Nonterminals())) {
+      next = &base::gotos[base::nonterminal_positions[idx_of(
+          symbol, Nonterminals())]][stack.back()];
+    } else {
+      next = &rows[stack.back()].actions[base::column(symbol)];
+    }
+    action const &act = *next;
+    if (act.type != action_type::Goto && act.type != action_type::Shift) {
+      counters::error(state_order[stack.back()]);
+      throw std::runtime_error("Invalid input symbol");
+    }
+    stack.push_back(act.idx);
+    push_value(std::move(symbol));
+    eval_unit_rules(act);
+    counters::stack_depth(stack.size());
+    counters::values(values.size());
+  }
+
+  // Continues parsing on top of the given state stack, without the values
+  // below it. Only reductions above `context.size()` states are valid then.
+  void restore(std::vector<size_t> const &context) {
+    reset();
+    stack = context;
+  }
+
+  constexpr Start &get_parse_result() {
     if (rows[stack.back()].actions[0].type == action_type::Accept) {
-      (eval_functions[rows[stack.back()].actions[0].produce_fn])(values);
+      eval(rows[stack.back()].actions[0].produce_fn);
+      counters::reduce(rows[stack.back()].actions[0].produce_fn);
       if constexpr (all_symbols(symbols())) {
         return *dynamic_cast<Start *>(values.back());
       } else {
@@ -775,14 +1815,170 @@ struct transition_table {
       throw std::runtime_error{"Parse result not available yet"};
     }
   }
+};
 
-  friend std::ostream &operator<<(std::ostream &stream,
-                                  transition_table const &table) {
-    for (auto &row : table.rows) {
-      stream << row << '\n';
+// Parses a complete input with a `Grammar::table`, fed by a `Grammar::lexer`
+// and closed by `Grammar::end`. Variant mode tables do this in constant
+// evaluation, so `constexpr auto result = parse<grammar>("3 * 7");` is folded
+// at compile time and malformed input fails to compile.
+template <typename Grammar> constexpr auto parse(std::string_view input) {
+  typename Grammar::table table;
+  typename Grammar::lexer tokens(input);
+  while (tokens.next(
+      [&table](auto &&token) { table.read_token(std::move(token)); })) {
+  }
+  table.read_token(typename Grammar::end());
+  return std::move(table.get_parse_result());
+}
+
+// Reports every shift as `handler.shift(token)` and every reduction as
+// `handler.reduce(rule<Lhs, Rhs...>())` without constructing nonterminals.
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Handler, typename Instrumentation,
+          typename Layout>
+struct transition_table<Start, Rules, Nonterminals, Terminals, events<Handler>,
+                        Instrumentation, Layout>
+    : parse_table<Start, Rules, Nonterminals, Terminals, Instrumentation,
+                  Layout> {
+  using base = parse_table<Start, Rules, Nonterminals, Terminals,
+                           Instrumentation, Layout>;
+  using typename base::counters;
+  using typename base::rules;
+  using base::rows;
+  using base::stack;
+  using base::state_order;
+
+  static constexpr std::array<void (*)(std::remove_reference_t<Handler> &),
+                              rules::num_elements>
+      reduce_functions =
+          init_event_fns<std::remove_reference_t<Handler>>(Rules());
+
+  Handler handler;
+
+  explicit transition_table(Handler handler = Handler())
+      : handler(std::forward<Handler>(handler)) {}
+
+  // Reports the unit rules that were folded into a shift or goto.
+  void reduce_unit_rules(action const &act) {
+    size_t first = base::chain_offsets[act.produce_fn];
+    for (size_t i = first; i < first + act.pop_nr; ++i) {
+      (reduce_functions[base::unit_chains[i]])(handler);
+      counters::reduce(base::unit_chains[i]);
     }
-    stream << '\n';
-    return stream;
+  }
+
+  template <typename Token> bool read_token(Token &&token) {
+    size_t const terminal_idx = base::column(token);
+    while (true) {
+      base::count_lookup(terminal_idx);
+      action const &act = rows[stack.back()].actions[terminal_idx];
+      switch (act.type) {
+      case action_type::Shift:
+        stack.push_back(act.idx);
+        handler.shift(std::move(token));
+        reduce_unit_rules(act);
+        base::shifted(terminal_idx);
+        counters::shift();
+        counters::stack_depth(stack.size());
+        return false;
+      case action_type::Reduce: {
+        (reduce_functions[act.produce_fn])(handler);
+        counters::reduce(act.produce_fn);
+        stack.resize(stack.size() - act.pop_nr);
+        reduce_unit_rules(base::push_goto(act.idx));
+        continue;
+      }
+      case action_type::Accept:
+        return true;
+      default:
+        counters::error(state_order[stack.back()]);
+        if constexpr (base::recovers) {
+          if (base::skips(terminal_idx)) {
+            return false;
+          }
+          action const &shift = base::recover(terminal_idx, 1, [] {});
+          stack.push_back(shift.idx);
+          handler.shift(error());
+          reduce_unit_rules(shift);
+          if (terminal_idx == base::error_idx) {
+            return false;
+          }
+          continue;
+        }
+        throw std::runtime_error("Invalid input token");
+      }
+    }
+  }
+
+  // Reports the reduction to the start symbol once the input is complete.
+  void finish() {
+    if (rows[stack.back()].actions[0].type == action_type::Accept) {
+      (reduce_functions[rows[stack.back()].actions[0].produce_fn])(handler);
+      counters::reduce(rows[stack.back()].actions[0].produce_fn);
+    } else {
+      throw std::runtime_error{"Parse result not available yet"};
+    }
+  }
+};
+
+template <typename Start, typename Rules, typename Nonterminals,
+          typename Terminals, typename Instrumentation, typename Layout>
+struct transition_table<Start, Rules, Nonterminals, Terminals, recognize,
+                        Instrumentation, Layout>
+    : parse_table<Start, Rules, Nonterminals, Terminals, Instrumentation,
+                  Layout> {
+  using base = parse_table<Start, Rules, Nonterminals, Terminals,
+                           Instrumentation, Layout>;
+  using typename base::counters;
+  using base::rows;
+  using base::stack;
+  using base::state_order;
+
+  bool read_kind(size_t terminal_idx) {
+    while (true) {
+      base::count_lookup(terminal_idx);
+      action const &act = rows[stack.back()].actions[terminal_idx];
+      switch (act.type) {
+      case action_type::Shift:
+        stack.push_back(act.idx);
+        base::shifted(terminal_idx);
+        counters::shift();
+        counters::stack_depth(stack.size());
+        return false;
+      case action_type::Reduce:
+        counters::reduce(act.produce_fn);
+        stack.resize(stack.size() - act.pop_nr);
+        base::push_goto(act.idx);
+        continue;
+      case action_type::Accept:
+        return true;
+      default:
+        counters::error(state_order[stack.back()]);
+        if constexpr (base::recovers) {
+          if (base::skips(terminal_idx)) {
+            return false;
+          }
+          stack.push_back(base::recover(terminal_idx, 1, [] {}).idx);
+          if (terminal_idx == base::error_idx) {
+            return false;
+          }
+          continue;
+        }
+        throw std::runtime_error("Invalid input token");
+      }
+    }
+  }
+
+  template <typename Token> bool read_token(kind<Token>) {
+    return read_kind(base::template column<Token>());
+  }
+
+  template <typename Token> bool read_token(Token const &token) {
+    return read_kind(base::column(token));
+  }
+
+  bool accepted() const noexcept {
+    return rows[stack.back()].actions[0].type == action_type::Accept;
   }
 };
 
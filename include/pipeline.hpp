@@ -0,0 +1,309 @@
+#if !defined(PIPELINE_HPP)
+#define PIPELINE_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <coroutine>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+namespace parser {
+
+// Something a suspended stage waits for.
+struct waiter {
+  virtual bool ready() const noexcept = 0;
+
+protected:
+  ~waiter() = default;
+};
+
+// A step of a pipeline, written as a coroutine that suspends whenever it
+// cannot push to a full queue or pop from an empty one. It does not run
+// before `step` is called, and `step` only resumes it once its queue is ready
+// again, so a stage never spins on its own.
+class stage {
+public:
+  struct promise_type {
+    waiter const *blocked = nullptr;
+    std::exception_ptr error;
+
+    stage get_return_object() noexcept {
+      return stage(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_always final_suspend() const noexcept { return {}; }
+    void return_void() const noexcept {}
+    void unhandled_exception() noexcept { error = std::current_exception(); }
+  };
+
+private:
+  std::coroutine_handle<promise_type> handle;
+
+  explicit stage(std::coroutine_handle<promise_type> handle) noexcept
+      : handle(handle) {}
+
+public:
+  stage(stage &&other) noexcept
+      : handle(std::exchange(other.handle, nullptr)) {}
+  stage &operator=(stage &&other) noexcept {
+    std::swap(handle, other.handle);
+    return *this;
+  }
+  ~stage() {
+    if (handle) {
+      handle.destroy();
+    }
+  }
+
+  bool done() const noexcept { return handle.done(); }
+
+  // Runs the stage until it suspends again, unless it still waits for its
+  // queue. Returns whether it ran, and rethrows what the stage threw.
+  bool step() {
+    auto &promise = handle.promise();
+    if (handle.done() || (promise.blocked && !promise.blocked->ready())) {
+      return false;
+    }
+    promise.blocked = nullptr;
+    handle.resume();
+    if (promise.error) {
+      std::rethrow_exception(promise.error);
+    }
+    return true;
+  }
+};
+
+// Bounded queue between one producing and one consuming stage, possibly on
+// different threads. Each side only writes its own index and caches the
+// other one, so a push or pop touches the shared cache lines only when the
+// cached index says the queue is full or empty. A full queue suspends its
+// producer, which is the pipeline's backpressure.
+template <typename T, size_t Capacity> class spsc_queue {
+  static_assert(std::has_single_bit(Capacity),
+                "Queue capacity has to be a power of two");
+  static constexpr size_t line = 64;
+
+  struct slot {
+    alignas(T) std::byte storage[sizeof(T)];
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+    void *raw() noexcept { return storage; }
+  };
+
+  // Written by the consumer, and its copy of `tail`.
+  alignas(line) std::atomic<size_t> head{0};
+  size_t cached_tail = 0;
+  // Written by the producer, and its copy of `head`.
+  alignas(line) std::atomic<size_t> tail{0};
+  size_t cached_head = 0;
+  alignas(line) std::array<slot, Capacity> slots;
+
+public:
+  spsc_queue() = default;
+  spsc_queue(spsc_queue const &) = delete;
+  spsc_queue &operator=(spsc_queue const &) = delete;
+  ~spsc_queue() { clear(); }
+
+  // Whether a push would fail, from the producer's side.
+  bool full() noexcept {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cached_head == Capacity) {
+      cached_head = head.load(std::memory_order_acquire);
+    }
+    return t - cached_head == Capacity;
+  }
+
+  // Whether a pop would fail, from the consumer's side.
+  bool empty() noexcept {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == cached_tail) {
+      cached_tail = tail.load(std::memory_order_acquire);
+    }
+    return h == cached_tail;
+  }
+
+  bool try_push(T &&value) {
+    if (full()) {
+      return false;
+    }
+    size_t t = tail.load(std::memory_order_relaxed);
+    ::new (slots[t & (Capacity - 1)].raw()) T(std::move(value));
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::optional<T> try_pop() {
+    if (empty()) {
+      return {};
+    }
+    size_t h = head.load(std::memory_order_relaxed);
+    T *at = slots[h & (Capacity - 1)].get();
+    std::optional<T> value(std::move(*at));
+    std::destroy_at(at);
+    head.store(h + 1, std::memory_order_release);
+    return value;
+  }
+
+  // Drops all queued values. Only call this while no stage uses the queue.
+  void clear() {
+    while (try_pop()) {
+    }
+  }
+
+  // Refers to the pushed value, which lives until the end of the `co_await`
+  // expression.
+  struct push_awaiter : waiter {
+    spsc_queue &queue;
+    T &value;
+
+    push_awaiter(spsc_queue &queue, T &value) : queue(queue), value(value) {}
+    bool ready() const noexcept override { return !queue.full(); }
+    bool await_ready() const noexcept { return ready(); }
+    void await_suspend(
+        std::coroutine_handle<stage::promise_type> handle) const noexcept {
+      handle.promise().blocked = this;
+    }
+    void await_resume() { queue.try_push(std::move(value)); }
+  };
+
+  struct pop_awaiter : waiter {
+    spsc_queue &queue;
+
+    explicit pop_awaiter(spsc_queue &queue) : queue(queue) {}
+    bool ready() const noexcept override { return !queue.empty(); }
+    bool await_ready() const noexcept { return ready(); }
+    void await_suspend(
+        std::coroutine_handle<stage::promise_type> handle) const noexcept {
+      handle.promise().blocked = this;
+    }
+    T await_resume() { return std::move(*queue.try_pop()); }
+  };
+
+  // `co_await queue.push(std::move(value))` in the producing stage, and
+  // `T value = co_await queue.pop()` in the consuming one. Push named values:
+  // GCC 12 destroys a braced temporary in a `co_await` operand twice.
+  push_awaiter push(T &&value) { return {*this, value}; }
+  pop_awaiter pop() { return pop_awaiter(*this); }
+};
+
+enum class placement {
+  // All stages take turns on the calling thread whenever one of them blocks.
+  one_thread,
+  // Every stage runs on a thread of its own, the last on the calling one.
+  thread_per_stage,
+};
+
+// Runs `stages` until all of them are done. If one throws, the others are
+// stopped where they are and the exception is rethrown.
+inline void run(std::span<stage> stages, placement where) {
+  if (where == placement::one_thread) {
+    while (true) {
+      bool done = true;
+      bool progress = false;
+      for (auto &s : stages) {
+        if (!s.done()) {
+          done = false;
+          progress = s.step() || progress;
+        }
+      }
+      if (done) {
+        return;
+      }
+      if (!progress) {
+        throw std::runtime_error("Pipeline stages wait for each other");
+      }
+    }
+  }
+  std::atomic<bool> failed{false};
+  std::vector<std::exception_ptr> errors(stages.size());
+  auto drive = [&](size_t i) {
+    try {
+      while (!stages[i].done() && !failed.load(std::memory_order_relaxed)) {
+        if (!stages[i].step()) {
+          std::this_thread::yield();
+        }
+      }
+    } catch (...) {
+      errors[i] = std::current_exception();
+      failed.store(true, std::memory_order_relaxed);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i + 1 < stages.size(); ++i) {
+    threads.emplace_back(drive, i);
+  }
+  if (!stages.empty()) {
+    drive(stages.size() - 1);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  for (auto &error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+// A token and the offset in the input where it starts.
+template <typename Token> struct located {
+  Token token;
+  size_t offset = 0;
+};
+
+// A piece of the input in one of a reader's buffers. The empty chunk ends
+// the input.
+struct chunk {
+  std::string_view text;
+  size_t buffer = 0;
+};
+
+#if __has_include(<unistd.h>)
+// Reads `fd` until its end with `read`, into whichever of the `buffers` the
+// consumer of `chunks` has handed back through `free_buffers`. With two
+// buffers, the next chunk is read while the last one is still being
+// tokenized. `free_buffers` has to hold every buffer index at the start.
+template <size_t N>
+stage read_chunks(int fd, std::array<std::vector<char>, N> &buffers,
+                  spsc_queue<size_t, N> &free_buffers,
+                  spsc_queue<chunk, N> &chunks) {
+  while (true) {
+    size_t buffer = co_await free_buffers.pop();
+    std::vector<char> &data = buffers[buffer];
+    ssize_t size = 0;
+    do {
+      size = ::read(fd, data.data(), data.size());
+    } while (size < 0 && errno == EINTR);
+    if (size < 0) {
+      throw std::runtime_error(std::string("Read failed: ") +
+                               std::strerror(errno));
+    }
+    chunk filled{std::string_view(data.data(), static_cast<size_t>(size)),
+                 buffer};
+    co_await chunks.push(std::move(filled));
+    if (size == 0) {
+      co_return;
+    }
+  }
+}
+#endif
+
+} // namespace parser
+
+#endif
@@ -11,13 +11,14 @@ template <typename Token> struct parse_result {
   std::string_view remaining;
 };
 
-template <std::string_view Prefix, typename Token> class scan_token {
+template <std::string_view const &Prefix, typename Token> class scan_token {
 
 public:
   static std::optional<parse_result<Token>> scan(std::string_view input) {
     if (input.find(Prefix) == 0) {
       return Token(input.substr(Prefix.length()));
     }
+    return {};
   }
 };
 
@@ -0,0 +1,181 @@
+#if !defined(SPECULATIVE_HPP)
+#define SPECULATIVE_HPP
+
+#include <algorithm>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parser.hpp"
+
+namespace parser {
+
+// Feeds `tokens` into a fresh table and returns the resulting state stack.
+// A synthetic prefix such as `[ 0 ,` yields the stack that every element of a
+// list is parsed on top of.
+template <typename Table, typename... Tokens>
+std::vector<size_t> predict_context(Tokens &&... tokens) {
+  Table table;
+  (table.read_token(std::forward<Tokens>(tokens)), ...);
+  return table.stack;
+}
+
+// Parses one large sequence `Element Separator Element ...` in parallel. The
+// input is cut at guessed separators, and every segment is parsed on its own
+// thread on top of a predicted stack `context`, without the values below it.
+// The completed elements are then pushed into the caller's table. A segment
+// is only used if the sequential parse reaches its start in exactly the
+// predicted state, so mispredicted segments are re-parsed sequentially.
+template <typename Table, typename Lexer, typename Element, typename Separator>
+class speculative_parser {
+  struct segment {
+    size_t cut = 0;
+    size_t start = 0;
+    size_t end = 0;
+    bool ok = false;
+    bool closed = false;
+    std::vector<typename Table::value_type> elements;
+  };
+
+  std::vector<Table> tables;
+  std::vector<segment> segments;
+  size_t min_segment_size;
+  char separator_char;
+
+  // Parses elements from `seg.start` until the first separator at or behind
+  // `limit`, or until the enclosing sequence is closed. Returns the offset at
+  // which the attempt failed, or `npos` on success.
+  static size_t try_segment(Table &table, std::string_view input,
+                            std::vector<size_t> const &context, segment &seg,
+                            size_t limit) {
+    size_t floor = context.size();
+    table.restore(context);
+    seg.elements.clear();
+    seg.closed = false;
+    Lexer tokens(input, seg.start);
+    try {
+      bool done = false;
+      bool failed = false;
+      while (!done) {
+        size_t before = tokens.offset();
+        bool more = tokens.next([&](auto &&token) {
+          using Token = std::decay_t<decltype(token)>;
+          if (table.read_token_above(std::move(token), floor) !=
+              read_status::floor_reached) {
+            return;
+          }
+          if (table.values.size() != 1) {
+            done = failed = true;
+            return;
+          }
+          seg.elements.push_back(std::move(table.values.back()));
+          table.values.clear();
+          table.stack.resize(floor);
+          if constexpr (std::is_same<Token, Separator>::value) {
+            seg.end = tokens.offset();
+            done = seg.end >= limit;
+          } else {
+            seg.end = before;
+            seg.closed = done = true;
+            // Only the sequence that ends the input may be closed here, any
+            // other closing token means the cut was too deep.
+            failed = tokens.next([](auto &&) {});
+          }
+        });
+        if (failed || !more) {
+          return tokens.offset();
+        }
+      }
+      return std::string_view::npos;
+    } catch (std::exception const &) {
+      return tokens.offset() + 1;
+    }
+  }
+
+  void parse_segment(Table &table, std::string_view input,
+                     std::vector<size_t> const &context, segment &seg,
+                     size_t limit) {
+    size_t from = seg.cut;
+    while (true) {
+      size_t cut = input.find(separator_char, from);
+      if (cut == std::string_view::npos || cut >= limit) {
+        seg.ok = false;
+        return;
+      }
+      seg.start = cut + 1;
+      from = try_segment(table, input, context, seg, limit);
+      if (from == std::string_view::npos) {
+        seg.ok = true;
+        return;
+      }
+      from = std::max(from, seg.start);
+    }
+  }
+
+public:
+  explicit speculative_parser(char separator_char,
+                              size_t num_threads =
+                                  std::thread::hardware_concurrency(),
+                              size_t min_segment_size = 1 << 16)
+      : tables(std::max<size_t>(num_threads, 1)),
+        min_segment_size(min_segment_size), separator_char(separator_char) {}
+
+  // Feeds all tokens of `input` into `table`. The caller still reads the
+  // end token and takes the parse result.
+  void parse(Table &table, std::string_view input,
+             std::vector<size_t> const &context) {
+    size_t num_segments =
+        std::min(tables.size(), input.size() / min_segment_size);
+    segments.assign(std::max<size_t>(num_segments, 1), segment{});
+    for (size_t i = 1; i < segments.size(); ++i) {
+      segments[i].cut = input.size() * i / num_segments;
+    }
+
+    std::vector<std::jthread> workers(segments.size());
+    for (size_t i = 1; i < segments.size(); ++i) {
+      size_t limit =
+          i + 1 < segments.size() ? segments[i + 1].cut : input.size();
+      workers[i] = std::jthread([&, i, limit] {
+        parse_segment(tables[i], input, context, segments[i], limit);
+      });
+    }
+
+    Lexer tokens(input);
+    size_t next = 1;
+    while (true) {
+      if (next < segments.size() && segments[next].cut <= tokens.offset()) {
+        if (workers[next].joinable()) {
+          workers[next].join();
+        }
+        segment &seg = segments[next];
+        if (!seg.ok || seg.start < tokens.offset()) {
+          ++next;
+          continue;
+        }
+        if (seg.start == tokens.offset() && table.stack == context) {
+          for (size_t i = 0; i < seg.elements.size(); ++i) {
+            table.read_symbol(std::move(get_symbol<Element>(seg.elements[i])));
+            if (!seg.closed || i + 1 < seg.elements.size()) {
+              table.read_token(Separator());
+            }
+          }
+          seg.elements.clear();
+          tokens = Lexer(input, seg.end);
+          ++next;
+          continue;
+        }
+      }
+      if (!tokens.next([&table](auto &&token) {
+            table.read_token(std::move(token));
+          })) {
+        break;
+      }
+    }
+  }
+};
+
+} // namespace parser
+
+#endif
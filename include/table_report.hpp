@@ -0,0 +1,191 @@
+#if !defined(TABLE_REPORT_HPP)
+#define TABLE_REPORT_HPP
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+#include "parser.hpp"
+
+namespace parser {
+
+// Readable name of a symbol type, without its namespaces.
+inline std::string symbol_name(std::type_info const &type) {
+  std::string name = type.name();
+#if __has_include(<cxxabi.h>)
+  int status = 0;
+  if (char *demangled =
+          abi::__cxa_demangle(type.name(), nullptr, nullptr, &status)) {
+    name = demangled;
+    std::free(demangled);
+  }
+#endif
+  if (size_t scope = name.rfind("::"); scope != std::string::npos) {
+    name.erase(0, scope + 2);
+  }
+  return name;
+}
+
+template <typename... Symbols>
+std::vector<std::string> symbol_names(set<Symbols...>) {
+  return {symbol_name(typeid(Symbols))...};
+}
+
+// Writes the automaton of `Table` in Graphviz dot format. Shifts are solid
+// edges, gotos dashed ones, and states that reduce are labelled with the
+// index of their rule.
+template <typename Table> void write_graphviz(std::ostream &stream) {
+  constexpr auto &rows = Table::rows;
+  constexpr auto &gotos = Table::gotos;
+  std::vector<std::string> names = symbol_names(typename Table::symbols());
+  size_t num_terminals = rows[0].actions.size();
+  stream << "digraph automaton {\n  rankdir=LR;\n  node [shape=circle];\n";
+  for (size_t state = 0; state < rows.size(); ++state) {
+    auto &actions = rows[state].actions;
+    std::string label = std::to_string(state) + '"';
+    for (auto &a : actions) {
+      if (a.type == action_type::Reduce) {
+        label = std::to_string(state) + "\\nreduce " +
+                std::to_string(a.produce_fn) + "\", shape=box";
+      } else if (a.type == action_type::Accept) {
+        label = std::to_string(state) + "\\naccept\", shape=doublecircle";
+      }
+    }
+    stream << "  " << state << " [label=\"" << label << "];\n";
+    for (size_t terminal = 0; terminal < num_terminals; ++terminal) {
+      if (actions[terminal].type == action_type::Shift) {
+        stream << "  " << state << " -> " << actions[terminal].idx
+               << " [label=\"" << names[Table::terminal_order[terminal]]
+               << "\"];\n";
+      }
+    }
+    for (size_t nonterminal = 0; nonterminal < gotos.size();
+         ++nonterminal) {
+      action const &a = gotos[nonterminal][state];
+      if (a.type == action_type::Goto) {
+        stream << "  " << state << " -> " << a.idx << " [label=\""
+               << names[num_terminals + Table::nonterminal_order[nonterminal]]
+               << "\", style=dashed];\n";
+      }
+    }
+  }
+  stream << "}\n";
+}
+
+// Writes `open`, then `items` separated by commas and as many per line as fit
+// into 80 columns, indented by `indent` after a line break, and `close`.
+inline void write_wrapped(std::ostream &stream, std::string_view open,
+                          std::vector<std::string> const &items,
+                          std::string_view close, size_t indent) {
+  stream << open;
+  size_t column = open.size() - (open.rfind('\n') + 1);
+  for (size_t i = 0; i < items.size(); ++i) {
+    std::string item = items[i];
+    item += i + 1 < items.size() ? std::string_view(",") : close;
+    size_t space = i > 0 ? 1 : 0;
+    if (column + space + item.size() > 80) {
+      stream << '\n' << std::string(indent, ' ');
+      column = indent;
+    } else if (space > 0) {
+      stream << ' ';
+      ++column;
+    }
+    stream << item;
+    column += item.size();
+  }
+  stream << '\n';
+}
+
+// Initializer of an action, without the members that are zero.
+inline std::string action_initializer(action const &a) {
+  static constexpr char const *types[] = {"Unreachable", "Goto", "Shift",
+                                          "Reduce", "Accept"};
+  size_t const members[] = {a.idx, a.pop_nr, a.produce_fn};
+  size_t used = 3;
+  while (used > 0 && members[used - 1] == 0) {
+    --used;
+  }
+  if (a.type == action_type::Unreachable && used == 0) {
+    return "{}";
+  }
+  std::string result = "{";
+  result += types[static_cast<size_t>(a.type)];
+  for (size_t i = 0; i < used; ++i) {
+    result += ", " + std::to_string(members[i]);
+  }
+  return result + "}";
+}
+
+template <size_t N>
+void write_table_array(std::ostream &stream, std::string const &member,
+                       std::array<size_t, N> const &values) {
+  std::vector<std::string> items;
+  for (size_t value : values) {
+    items.push_back(std::to_string(value));
+  }
+  write_wrapped(stream,
+                "  static constexpr std::array<size_t, " + std::to_string(N) +
+                    "> " + member + " = {",
+                items, "};", 6);
+}
+
+template <size_t Outer, size_t Inner>
+void write_table_array(
+    std::ostream &stream, std::string const &member,
+    std::array<std::array<action, Inner>, Outer> const &actions) {
+  stream << "  static constexpr std::array<std::array<parser::action, " << Inner
+         << ">, " << Outer << ">\n      " << member << " = {{\n";
+  for (size_t i = 0; i < Outer; ++i) {
+    std::vector<std::string> items;
+    for (auto &a : actions[i]) {
+      items.push_back(action_initializer(a));
+    }
+    write_wrapped(stream, "          {{", items,
+                  i + 1 < Outer ? "}}," : "}}}};", 12);
+  }
+}
+
+// Writes the tables of `Table` as a struct `name` of `static constexpr`
+// arrays. Tables of the same grammar with the `precompiled<name>` layout then
+// use them instead of constructing the automaton again.
+template <typename Table>
+void write_tables(std::ostream &stream, std::string_view name) {
+  std::array<std::array<action, Table::rows[0].actions.size()>,
+             Table::num_states>
+      actions{};
+  for (size_t state = 0; state < Table::num_states; ++state) {
+    actions[state] = Table::rows[state].actions;
+  }
+  constexpr table_stats stats = Table::stats();
+  stream << "struct " << name << " {\n  using enum parser::action_type;\n\n";
+  write_table_array(stream, "actions", actions);
+  write_table_array(stream, "gotos", Table::gotos);
+  write_table_array(stream, "unit_chains", Table::unit_chains);
+  write_table_array(stream, "chain_offsets", Table::chain_offsets);
+  write_table_array(stream, "state_order", Table::state_order);
+  write_table_array(stream, "terminal_order", Table::terminal_order);
+  write_table_array(stream, "nonterminal_order", Table::nonterminal_order);
+  write_wrapped(stream, "  static constexpr parser::table_stats stats = {",
+                {std::to_string(stats.num_states),
+                 std::to_string(stats.num_terminals),
+                 std::to_string(stats.num_nonterminals),
+                 std::to_string(stats.num_rules),
+                 std::to_string(stats.table_bytes),
+                 std::to_string(stats.num_cells),
+                 std::to_string(stats.used_cells),
+                 std::to_string(stats.max_rhs),
+                 stats.has_conflict ? "true" : "false"},
+                "};", 6);
+  stream << "};\n";
+}
+
+} // namespace parser
+
+#endif
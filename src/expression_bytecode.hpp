@@ -0,0 +1,329 @@
+#if !defined(EXPRESSION_BYTECODE_HPP)
+#define EXPRESSION_BYTECODE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "expression_grammar.hpp"
+#include "parser.hpp"
+
+// Expressions over the variables `a` to `z`, compiled once into postfix
+// bytecode and evaluated over many rows. The reductions emit code instead of
+// computing values: constant subexpressions are folded, and an operation on a
+// constant or variable takes it as its operand instead of from the stack.
+// `+` and `*` bind by their precedence, and arithmetic wraps around like
+// unsigned 32 bit integers.
+namespace expression::bytecode {
+
+enum class opcode : uint8_t {
+  // Push `operand`, or the variable with index `operand`.
+  constant,
+  load,
+  // Replace the two topmost values by their sum or product.
+  add,
+  multiply,
+  // Combine the topmost value with `operand` or a variable.
+  add_constant,
+  multiply_constant,
+  add_load,
+  multiply_load,
+};
+
+struct instruction {
+  opcode op = opcode::constant;
+  int32_t operand = 0;
+};
+
+constexpr int32_t wrapping_add(int32_t l, int32_t r) noexcept {
+  return static_cast<int32_t>(static_cast<uint32_t>(l) +
+                              static_cast<uint32_t>(r));
+}
+
+constexpr int32_t wrapping_multiply(int32_t l, int32_t r) noexcept {
+  return static_cast<int32_t>(static_cast<uint32_t>(l) *
+                              static_cast<uint32_t>(r));
+}
+
+// Bytecode of a subexpression.
+struct A {
+  std::vector<instruction> code;
+
+  A(id &&i) : code{{opcode::constant, i.value}} {}
+  A(variable &&v) : code{{opcode::load, static_cast<int32_t>(v.index)}} {}
+  A(lparen, A &&a, rparen) : code(std::move(a.code)) {}
+  A(A &&l, plus, A &&r) : code(combine(std::move(l), opcode::add, r)) {}
+  A(A &&l, times, A &&r) : code(combine(std::move(l), opcode::multiply, r)) {}
+
+private:
+  static bool leaf(std::vector<instruction> const &code) noexcept {
+    return code.size() == 1;
+  }
+
+  static int32_t fold(opcode op, int32_t l, int32_t r) noexcept {
+    return op == opcode::add ? wrapping_add(l, r) : wrapping_multiply(l, r);
+  }
+
+  // Appends `r` and `op` to `l`. Both operations are commutative, so a leaf
+  // on the left is swapped to the right, where it becomes an operand.
+  static std::vector<instruction> combine(A &&l, opcode op, A &r) {
+    std::vector<instruction> code = std::move(l.code);
+    if (leaf(code) && !leaf(r.code)) {
+      std::swap(code, r.code);
+    }
+    if (!leaf(r.code)) {
+      code.insert(code.end(), r.code.begin(), r.code.end());
+      code.push_back({op});
+      return code;
+    }
+    instruction operand = r.code[0];
+    bool constant = operand.op == opcode::constant;
+    opcode fused = op == opcode::add
+                       ? (constant ? opcode::add_constant : opcode::add_load)
+                       : (constant ? opcode::multiply_constant
+                                   : opcode::multiply_load);
+    if (constant && leaf(code) && code[0].op == opcode::constant) {
+      code[0].operand = fold(op, code[0].operand, operand.operand);
+    } else if (constant && code.back().op == fused) {
+      code.back().operand = fold(op, code.back().operand, operand.operand);
+    } else {
+      code.push_back({fused, operand.operand});
+    }
+    return code;
+  }
+};
+
+// Compiled expression with the stack depth and variables it needs.
+class program {
+  std::vector<instruction> code;
+  size_t depth = 0;
+  size_t variables = 0;
+
+public:
+  explicit program(std::vector<instruction> &&instructions)
+      : code(std::move(instructions)) {
+    size_t size = 0;
+    for (auto &i : code) {
+      switch (i.op) {
+      case opcode::constant:
+        depth = std::max(depth, ++size);
+        break;
+      case opcode::load:
+        depth = std::max(depth, ++size);
+        [[fallthrough]];
+      case opcode::add_load:
+      case opcode::multiply_load:
+        variables = std::max(variables, static_cast<size_t>(i.operand) + 1);
+        break;
+      case opcode::add:
+      case opcode::multiply:
+        --size;
+        break;
+      default:
+        break;
+      }
+    }
+  }
+
+  std::vector<instruction> const &instructions() const noexcept {
+    return code;
+  }
+
+  size_t stack_depth() const noexcept { return depth; }
+
+  // One more than the highest variable index.
+  size_t num_variables() const noexcept { return variables; }
+};
+
+struct S {
+  program result;
+  S(A &&a, end) : result(std::move(a.code)) {}
+};
+
+using rules = set<rule<S, A, end>, rule<A, A, plus, A>, rule<A, A, times, A>,
+                  rule<A, id>, rule<A, variable>, rule<A, lparen, A, rparen>>;
+using terminals = set<id, variable, lparen, rparen, plus, times, end>;
+using nonterminals = set<S, A>;
+
+using table = transition_table<S, rules, nonterminals, terminals>;
+
+static_assert(!table::stats().has_conflict,
+              "Precedence declarations leave conflicts");
+
+class compiler {
+  table parse_table;
+
+public:
+  std::optional<program> compile(std::string_view input) {
+    parse_table.reset();
+    basic_lexer<true> tokens(input);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &e) {
+      std::cout << e.what() << '\n';
+      return {};
+    }
+    return std::move(parse_table.get_parse_result().result);
+  }
+};
+
+// Element wise operations on `n` values, 8 at a time with AVX2.
+struct add_op {
+  static int32_t apply(int32_t l, int32_t r) { return wrapping_add(l, r); }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i l, __m256i r) { return _mm256_add_epi32(l, r); }
+#endif
+};
+
+struct multiply_op {
+  static int32_t apply(int32_t l, int32_t r) {
+    return wrapping_multiply(l, r);
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i l, __m256i r) {
+    return _mm256_mullo_epi32(l, r);
+  }
+#endif
+};
+
+template <typename Op>
+void apply(int32_t *values, int32_t const *operands, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 8 <= n; i += 8) {
+    auto *at = reinterpret_cast<__m256i *>(values + i);
+    _mm256_storeu_si256(
+        at, Op::apply(_mm256_loadu_si256(at),
+                      _mm256_loadu_si256(
+                          reinterpret_cast<__m256i const *>(operands + i))));
+  }
+#endif
+  for (; i < n; ++i) {
+    values[i] = Op::apply(values[i], operands[i]);
+  }
+}
+
+template <typename Op> void apply(int32_t *values, int32_t operand, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  __m256i const broadcast = _mm256_set1_epi32(operand);
+  for (; i + 8 <= n; i += 8) {
+    auto *at = reinterpret_cast<__m256i *>(values + i);
+    _mm256_storeu_si256(at, Op::apply(_mm256_loadu_si256(at), broadcast));
+  }
+#endif
+  for (; i < n; ++i) {
+    values[i] = Op::apply(values[i], operand);
+  }
+}
+
+// Runs programs over many rows. The stack holds a block of `block_size` rows
+// per entry, so every instruction is a few vector operations per row, and
+// the stack is kept across calls.
+class evaluator {
+  static constexpr size_t block_size = 512;
+  std::vector<int32_t> stack;
+
+  int32_t *slot(size_t i) noexcept { return stack.data() + i * block_size; }
+
+public:
+  // Value of `p` for one row, where `row[k]` is the value of variable `k`.
+  int32_t evaluate(program const &p, int32_t const *row) {
+    stack.resize(std::max(stack.size(), p.stack_depth()));
+    size_t size = 0;
+    for (auto &i : p.instructions()) {
+      switch (i.op) {
+      case opcode::constant:
+        stack[size++] = i.operand;
+        break;
+      case opcode::load:
+        stack[size++] = row[i.operand];
+        break;
+      case opcode::add:
+        --size;
+        stack[size - 1] = wrapping_add(stack[size - 1], stack[size]);
+        break;
+      case opcode::multiply:
+        --size;
+        stack[size - 1] = wrapping_multiply(stack[size - 1], stack[size]);
+        break;
+      case opcode::add_constant:
+        stack[size - 1] = wrapping_add(stack[size - 1], i.operand);
+        break;
+      case opcode::multiply_constant:
+        stack[size - 1] = wrapping_multiply(stack[size - 1], i.operand);
+        break;
+      case opcode::add_load:
+        stack[size - 1] = wrapping_add(stack[size - 1], row[i.operand]);
+        break;
+      case opcode::multiply_load:
+        stack[size - 1] = wrapping_multiply(stack[size - 1], row[i.operand]);
+        break;
+      }
+    }
+    return stack[0];
+  }
+
+  // Writes the value of `p` for every row to `out`, where `columns[k]` holds
+  // the values of variable `k` for all `out.size()` rows.
+  void evaluate(program const &p, std::span<int32_t const *const> columns,
+                std::span<int32_t> out) {
+    if (columns.size() < p.num_variables()) {
+      throw std::runtime_error("Missing variable column");
+    }
+    stack.resize(std::max(stack.size(), p.stack_depth() * block_size));
+    for (size_t begin = 0; begin < out.size(); begin += block_size) {
+      size_t n = std::min(block_size, out.size() - begin);
+      size_t size = 0;
+      for (auto &i : p.instructions()) {
+        switch (i.op) {
+        case opcode::constant:
+          std::fill_n(slot(size++), n, i.operand);
+          break;
+        case opcode::load:
+          std::copy_n(columns[i.operand] + begin, n, slot(size++));
+          break;
+        case opcode::add:
+          --size;
+          apply<add_op>(slot(size - 1), slot(size), n);
+          break;
+        case opcode::multiply:
+          --size;
+          apply<multiply_op>(slot(size - 1), slot(size), n);
+          break;
+        case opcode::add_constant:
+          apply<add_op>(slot(size - 1), i.operand, n);
+          break;
+        case opcode::multiply_constant:
+          apply<multiply_op>(slot(size - 1), i.operand, n);
+          break;
+        case opcode::add_load:
+          apply<add_op>(slot(size - 1), columns[i.operand] + begin, n);
+          break;
+        case opcode::multiply_load:
+          apply<multiply_op>(slot(size - 1), columns[i.operand] + begin, n);
+          break;
+        }
+      }
+      std::copy_n(slot(0), n, out.data() + begin);
+    }
+  }
+};
+
+} // namespace expression::bytecode
+
+#endif
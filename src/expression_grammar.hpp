@@ -0,0 +1,246 @@
+#if !defined(EXPRESSION_GRAMMAR_HPP)
+#define EXPRESSION_GRAMMAR_HPP
+
+#include <iostream>
+#include <optional>
+#include <string_view>
+
+#include "glr.hpp"
+#include "parser.hpp"
+
+namespace expression {
+
+using namespace parser;
+
+struct id {
+  int value = 0;
+  constexpr id(int value) : value(value) {}
+  friend std::ostream &operator<<(std::ostream &stream, id const &i) {
+    stream << i.value;
+    return stream;
+  }
+};
+
+struct lparen {
+  friend std::ostream &operator<<(std::ostream &stream, lparen const &) {
+    stream << '(';
+    return stream;
+  }
+};
+
+struct rparen {
+  friend std::ostream &operator<<(std::ostream &stream, rparen const &) {
+    stream << ')';
+    return stream;
+  }
+};
+
+struct plus : left_assoc<1> {
+  friend std::ostream &operator<<(std::ostream &stream, plus const &) {
+    stream << '+';
+    return stream;
+  }
+};
+
+struct times : left_assoc<2> {
+  friend std::ostream &operator<<(std::ostream &stream, times const &) {
+    stream << '*';
+    return stream;
+  }
+};
+
+struct end {
+  friend std::ostream &operator<<(std::ostream &stream, end const &) {
+    stream << '$';
+    return stream;
+  }
+};
+
+struct E;
+
+struct T {
+  int value = 0;
+  constexpr T(lparen, E &&e, rparen);
+  constexpr T(id &&i) : value(i.value) {}
+  friend std::ostream &operator<<(std::ostream &stream, T const &) {
+    stream << 'T';
+    return stream;
+  }
+};
+
+struct E {
+  int value = 0;
+  constexpr E(T &&p) : value(p.value) {}
+  constexpr E(E &&e, plus, T &&p) : value(e.value + p.value) {}
+  constexpr E(E &&e, times, T &&p) : value(e.value * p.value) {}
+  friend std::ostream &operator<<(std::ostream &stream, E const &) {
+    stream << 'E';
+    return stream;
+  }
+};
+
+constexpr T::T(lparen, E &&e, rparen) : value(e.value) {}
+
+struct S {
+  int value = 0;
+  constexpr S(E &&e, end) : value(e.value) {}
+  friend std::ostream &operator<<(std::ostream &stream, S const &) {
+    stream << 'S';
+    return stream;
+  }
+};
+
+using rule1 = rule<S, E, end>;
+using rule2 = rule<E, E, plus, T>;
+using rule4 = rule<T, id>;
+using rule5 = rule<E, E, times, T>;
+using rule6 = rule<T, lparen, E, rparen>;
+using rule7 = rule<E, T>;
+
+using rules = set<rule1, rule2, rule4, rule5, rule6, rule7>;
+using terminals = set<id, lparen, rparen, plus, times, end>;
+using nonterminals = set<S, E, T>;
+
+using table = transition_table<S, rules, nonterminals, terminals>;
+
+static_assert(within(table::stats(), {.max_bytes = 4 * 1024}),
+              "Expression table exceeds its size budget");
+
+// The same language with a single operator nonterminal, which is ambiguous:
+// `1 + 2 * 3` has two derivations, so only a `glr_table` parses it.
+struct A {
+  int value = 0;
+  A(id &&i) : value(i.value) {}
+  A(lparen, A &&a, rparen) : value(a.value) {}
+  A(A &&l, plus, A &&r) : value(l.value + r.value) {}
+  A(A &&l, times, A &&r) : value(l.value * r.value) {}
+};
+
+struct AS {
+  int value = 0;
+  AS(A &&a, end) : value(a.value) {}
+};
+
+using ambiguous_rules =
+    set<rule<AS, A, end>, rule<A, A, plus, A>, rule<A, A, times, A>,
+        rule<A, id>, rule<A, lparen, A, rparen>>;
+using ambiguous_nonterminals = set<AS, A>;
+
+using ambiguous_table =
+    glr_table<AS, ambiguous_rules, ambiguous_nonterminals, terminals>;
+
+// `plus` and `times` declare their precedence, which resolves the conflicts
+// of the ambiguous grammar in an LR table with fewer states than `table`.
+using precedence_table =
+    transition_table<AS, ambiguous_rules, ambiguous_nonterminals, terminals>;
+
+static_assert(within(precedence_table::stats(), {.max_bytes = 4 * 1024}),
+              "Precedence table exceeds its size budget or has conflicts");
+
+// Variable `a` to `z` of an expression, by index from 0 to 25.
+struct variable {
+  size_t index = 0;
+  constexpr variable(size_t index) : index(index) {}
+};
+
+// Splits the input into tokens one at a time, see `json::lexer`. With
+// `Variables`, lower case letters are emitted as `variable`s.
+template <bool Variables> class basic_lexer {
+  std::string_view input;
+  size_t position = 0;
+  size_t start = 0;
+
+public:
+  constexpr basic_lexer(std::string_view input, size_t position = 0)
+      : input(input), position(position), start(position) {}
+
+  constexpr size_t offset() const noexcept { return position; }
+
+  constexpr size_t token_start() const noexcept { return start; }
+
+  template <typename Emit> constexpr bool next(Emit &&emit) {
+    while (position < input.size()) {
+      start = position;
+      switch (input[position++]) {
+      case ' ':
+      case '\t':
+      case '\f':
+      case '\v':
+        continue;
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+        emit(id(input[start] - '0'));
+        break;
+      case '+':
+        emit(plus());
+        break;
+      case '*':
+        emit(times());
+        break;
+      case '(':
+        emit(lparen());
+        break;
+      case ')':
+        emit(rparen());
+        break;
+      default:
+        if constexpr (Variables) {
+          if (input[start] >= 'a' && input[start] <= 'z') {
+            emit(variable(input[start] - 'a'));
+            break;
+          }
+        }
+        --position;
+        throw std::runtime_error("Invalid character");
+      }
+      return true;
+    }
+    start = position;
+    return false;
+  }
+};
+
+using lexer = basic_lexer<false>;
+
+template <typename Table> class basic_scanner {
+  Table parse_table;
+
+public:
+  std::optional<int> parse(std::string_view input) {
+    parse_table.reset();
+    lexer tokens(input);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &e) {
+      std::cout << e.what() << '\n';
+      return {};
+    }
+    return {parse_table.get_parse_result().value};
+  }
+};
+
+using scanner = basic_scanner<table>;
+
+// Everything `parser::parse` needs to parse an expression, also at compile
+// time.
+struct grammar {
+  using table = expression::table;
+  using lexer = expression::lexer;
+  using end = expression::end;
+};
+
+} // namespace expression
+
+#endif
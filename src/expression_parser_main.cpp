@@ -3,154 +3,12 @@
 #include <string>
 #include <vector>
 
+#include "expression_bytecode.hpp"
+#include "expression_grammar.hpp"
 #include "parser.hpp"
 #include "scanner.hpp"
 using namespace parser;
-
-struct id {
-  int value = 0;
-  id(int value) : value(value) {}
-  friend std::ostream &operator<<(std::ostream &stream, id const &i) {
-    stream << i.value;
-    return stream;
-  }
-};
-
-struct lparen {
-  friend std::ostream &operator<<(std::ostream &stream, lparen const &) {
-    stream << '(';
-    return stream;
-  }
-};
-
-struct rparen {
-  friend std::ostream &operator<<(std::ostream &stream, rparen const &) {
-    stream << ')';
-    return stream;
-  }
-};
-
-struct plus {
-  friend std::ostream &operator<<(std::ostream &stream, plus const &) {
-    stream << '+';
-    return stream;
-  }
-};
-
-struct times {
-  friend std::ostream &operator<<(std::ostream &stream, times const &) {
-    stream << '*';
-    return stream;
-  }
-};
-
-struct end {
-  friend std::ostream &operator<<(std::ostream &stream, end const &) {
-    stream << '$';
-    return stream;
-  }
-};
-
-struct E;
-
-struct T {
-  int value = 0;
-  T(lparen, E &&e, rparen);
-  T(id &&i) : value(i.value) {}
-  friend std::ostream &operator<<(std::ostream &stream, T const &) {
-    stream << 'T';
-    return stream;
-  }
-};
-
-struct E {
-  int value = 0;
-  E(T &&p) : value(p.value) {}
-  E(E &&e, plus, T &&p) : value(e.value + p.value) {}
-  E(E &&e, times, T &&p) : value(e.value * p.value) {}
-  friend std::ostream &operator<<(std::ostream &stream, E const &) {
-    stream << 'E';
-    return stream;
-  }
-};
-
-T::T(lparen, E &&e, rparen) : value(e.value) {}
-
-struct S {
-  int value = 0;
-  S(E &&e, end) : value(e.value) {}
-  friend std::ostream &operator<<(std::ostream &stream, S const &) {
-    stream << 'S';
-    return stream;
-  }
-};
-
-using rule1 = rule<S, E, end>;
-using rule2 = rule<E, E, plus, T>;
-using rule4 = rule<T, id>;
-using rule5 = rule<E, E, times, T>;
-using rule6 = rule<T, lparen, E, rparen>;
-using rule7 = rule<E, T>;
-
-using rules = set<rule1, rule2, rule4, rule5, rule6, rule7>;
-using terminals = set<id, lparen, rparen, plus, times, end>;
-using nonterminals = set<S, E, T>;
-
-class scanner {
-  transition_table<S, rules, nonterminals, terminals> table;
-
-public:
-  std::optional<int> parse(std::string_view input) {
-    while (!input.empty()) {
-      try {
-        switch (input[0]) {
-        case ' ':
-        case '\t':
-        case '\f':
-        case '\v':
-          break;
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-          table.read_token(id(input[0] - '0'));
-          break;
-        case '+':
-          table.read_token(plus());
-          break;
-        case '*':
-          table.read_token(times());
-          break;
-        case '(':
-          table.read_token(lparen());
-          break;
-        case ')':
-          table.read_token(rparen());
-          break;
-        default:
-          return {};
-        }
-      } catch (std::exception const &e) {
-        std::cout << e.what() << '\n';
-        return {};
-      }
-      input = input.substr(1);
-    }
-    try {
-      table.read_token(end());
-    } catch (std::exception const &e) {
-      std::cout << e.what() << '\n';
-      return {};
-    }
-    return {table.get_parse_result().value};
-  }
-};
+using namespace expression;
 
 int main() {
   transition_table<S, rules, nonterminals, terminals> table;
@@ -164,5 +22,51 @@ int main() {
     std::cout << "Parsing failed\n";
   }
 
+  constexpr S folded = parse<grammar>("(1 + 2) * 7");
+  static_assert(folded.value == 21);
+  std::cout << "Parsed at compile time: " << folded.value << '\n';
+
+  using counted_table = transition_table<S, rules, nonterminals, terminals,
+                                         build_values, instrumentation>;
+  basic_scanner<counted_table> counted_scan;
+  counted_scan.parse("(1 + 2) * 3 + 4"sv);
+  counted_scan.parse("1 + + 2"sv);
+  std::cout << counted_table::statistics();
+
+  basic_scanner<precedence_table> flat;
+  std::cout << "With precedence: 1 + 2 * 3 = " << *flat.parse("1 + 2 * 3"sv)
+            << ", " << precedence_table::stats().num_states << " instead of "
+            << table::stats().num_states << " states\n";
+
+  bytecode::compiler compiler;
+  if (auto filter = compiler.compile("(a + 1) * b + 2 * 3"sv)) {
+    std::vector<int32_t> a = {1, 2, 3, 4};
+    std::vector<int32_t> b = {10, 20, 30, 40};
+    std::vector<int32_t const *> columns = {a.data(), b.data()};
+    std::vector<int32_t> out(a.size());
+    bytecode::evaluator().evaluate(*filter, columns, out);
+    std::cout << "Bytecode: " << filter->instructions().size()
+              << " instructions, rows evaluate to";
+    for (int32_t value : out) {
+      std::cout << ' ' << value;
+    }
+    std::cout << '\n';
+  }
+
+  ambiguous_table glr;
+  for (auto input : {"1 + 2 * 3"sv, "1 + 2 * 3 + 4"sv}) {
+    glr.reset();
+    lexer tokens(input);
+    while (tokens.next([&glr](auto &&token) { glr.read_token(token); })) {
+    }
+    glr.read_token(end());
+    if (glr.finish()) {
+      std::cout << "GLR parse of " << input << ": "
+                << glr.forest.num_ambiguous() << " ambiguous nodes, "
+                << glr.forest.nodes.size() << " forest nodes, first value "
+                << glr.evaluate().value << '\n';
+    }
+  }
+
   return 0;
 }
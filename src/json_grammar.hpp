@@ -0,0 +1,1129 @@
+#if !defined(JSON_GRAMMAR_HPP)
+#define JSON_GRAMMAR_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "incremental.hpp"
+#include "interner.hpp"
+#include "json_profile.hpp"
+#include "parser.hpp"
+#include "speculative.hpp"
+
+#if !defined(JSON_COMPUTE_TABLES)
+#include "json_tables.hpp"
+#endif
+
+namespace json {
+
+using namespace parser;
+
+// Concrete type of a `json_value`, so consumers like `writer` can switch on
+// it instead of calling a virtual function per value.
+enum class json_kind : uint8_t {
+  null,
+  error,
+  boolean,
+  number,
+  string,
+  object,
+  list,
+};
+
+struct json_value {
+  json_kind const kind;
+  explicit json_value(json_kind kind) : kind(kind) {}
+  virtual ~json_value() = 0;
+};
+
+inline json_value::~json_value() {}
+
+struct json_null : json_value, symbol {
+  json_null() : json_value(json_kind::null) {}
+  ~json_null() override {}
+};
+
+// Placeholder for input that error recovery skipped.
+struct json_error : json_value {
+  json_error() : json_value(json_kind::error) {}
+  ~json_error() override {}
+};
+
+struct string : symbol {
+  std::string value;
+  string(std::string_view value) : value(value) {}
+  string(string &&) = default;
+  ~string() override {}
+};
+
+struct json_string : json_value, symbol {
+  std::string value;
+  json_string(string &&value)
+      : json_value(json_kind::string), value(std::move(value.value)) {}
+  json_string(json_string &&other) = default;
+  ~json_string() override {}
+};
+
+struct json_number : json_value, symbol {
+  double value;
+  json_number(double value) : json_value(json_kind::number), value(value) {}
+  ~json_number() override {}
+};
+
+struct true_ : symbol {};
+struct false_ : symbol {};
+struct json_bool : json_value, symbol {
+  bool value;
+  json_bool(true_) : json_value(json_kind::boolean), value(true) {}
+  json_bool(false_) : json_value(json_kind::boolean), value(false) {}
+  json_bool(bool value) : json_value(json_kind::boolean), value(value) {}
+  ~json_bool() override {}
+};
+
+struct lbrace : symbol {};
+struct rbrace : symbol {};
+
+struct lbracket : symbol {};
+struct rbracket : symbol {};
+
+struct colon : symbol {};
+struct comma : symbol {};
+
+struct end : symbol {};
+
+// Member names are interned into process wide ids, see `parser::interner`.
+using member_names = interner<struct member_name_tag>;
+
+struct V;
+struct json_member : symbol {
+  uint32_t key = member_names::npos;
+  std::unique_ptr<json_value> value;
+  // The name if the interner was full, see `interner::capacity`.
+  std::unique_ptr<std::string> spilled;
+  json_member(string &&name, colon, V &&value);
+  json_member(error &&) : value(new json_error) {}
+  json_member(json_member &&) = default;
+  ~json_member() override {}
+
+  // Members that error recovery made up have neither a `key` nor a name.
+  bool named() const noexcept {
+    return key != member_names::npos || spilled;
+  }
+
+  std::string_view name() const {
+    return spilled ? std::string_view(*spilled) : member_names::name(key);
+  }
+};
+
+struct M : symbol {
+  std::vector<json_member> members;
+  M(json_member &&member) { members.emplace_back(std::move(member)); }
+  M(M &&m, comma, json_member &&member) : members(std::move(m.members)) {
+    members.emplace_back(std::move(member));
+  }
+  ~M() override {}
+};
+
+// Position of the first member with each key of a large object, in an open
+// addressing table over the interned ids.
+class member_index {
+  static constexpr uint32_t empty = member_names::npos;
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t> positions;
+  size_t mask = 0;
+
+  static size_t hash(uint32_t key) noexcept { return key * 0x9e3779b1u; }
+
+public:
+  template <typename Member>
+  explicit member_index(std::vector<Member> const &members) {
+    size_t capacity = 1;
+    while (capacity < 2 * members.size()) {
+      capacity *= 2;
+    }
+    keys.assign(capacity, empty);
+    positions.resize(capacity);
+    mask = capacity - 1;
+    for (size_t i = 0; i < members.size(); ++i) {
+      size_t slot = hash(members[i].key) & mask;
+      while (keys[slot] != empty && keys[slot] != members[i].key) {
+        slot = (slot + 1) & mask;
+      }
+      if (keys[slot] == empty) {
+        keys[slot] = members[i].key;
+        positions[slot] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+
+  // The index of `members` kept in `slot`, which is built on the first call
+  // and safe from concurrent readers.
+  template <typename Member>
+  static member_index const &of(std::atomic<member_index const *> &slot,
+                                std::vector<Member> const &members) {
+    member_index const *built = slot.load(std::memory_order_acquire);
+    if (!built) {
+      auto fresh = std::make_unique<member_index>(members);
+      if (slot.compare_exchange_strong(built, fresh.get(),
+                                       std::memory_order_acq_rel)) {
+        built = fresh.release();
+      }
+    }
+    return *built;
+  }
+
+  // Position of the first member with `key`, or `npos`.
+  size_t find(uint32_t key) const noexcept {
+    for (size_t slot = hash(key) & mask; keys[slot] != empty;
+         slot = (slot + 1) & mask) {
+      if (keys[slot] == key) {
+        return positions[slot];
+      }
+    }
+    return std::string_view::npos;
+  }
+};
+
+struct json_object : json_value, symbol {
+  // Objects with more members are parsed into `indexed_object`s.
+  static constexpr size_t linear_lookup_limit = 16;
+
+  std::vector<json_member> members;
+  json_object(lbrace, M &&m, rbrace)
+      : json_value(json_kind::object), members(std::move(m.members)) {}
+  json_object(lbrace, rbrace) : json_value(json_kind::object) {}
+  json_object(json_object &&) = default;
+  ~json_object() override {}
+
+  // Value of the first member with the interned `key`, or `nullptr`. Small
+  // objects are scanned, large ones look `key` up in their index.
+  json_value const *find(uint32_t key) const;
+
+  // Value of the first member named `name`, or `nullptr`.
+  json_value const *find(std::string_view name) const {
+    if (uint32_t key = member_names::find(name); key != member_names::npos) {
+      return find(key);
+    }
+    if (member_names::full()) {
+      for (auto &member : members) {
+        if (member.spilled && *member.spilled == name) {
+          return member.value.get();
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // Drops the index, which has to happen after changing `members`.
+  void reindex();
+};
+
+// An object with more than `linear_lookup_limit` members. Its `member_index`
+// is a side allocation built on the first lookup, so smaller objects carry
+// neither the index nor a pointer to it.
+struct indexed_object final : json_object {
+  mutable std::atomic<member_index const *> index{nullptr};
+  indexed_object(json_object &&object) : json_object(std::move(object)) {}
+  ~indexed_object() override { delete index.load(); }
+};
+
+inline json_value const *json_object::find(uint32_t key) const {
+  if (members.size() > linear_lookup_limit) {
+    if (auto indexed = dynamic_cast<indexed_object const *>(this)) {
+      size_t position = member_index::of(indexed->index, members).find(key);
+      return position < members.size() ? members[position].value.get()
+                                       : nullptr;
+    }
+  }
+  for (auto &member : members) {
+    if (member.key == key) {
+      return member.value.get();
+    }
+  }
+  return nullptr;
+}
+
+inline void json_object::reindex() {
+  if (auto indexed = dynamic_cast<indexed_object *>(this)) {
+    delete indexed->index.exchange(nullptr);
+  }
+}
+
+struct L : symbol {
+  std::vector<std::unique_ptr<json_value>> values;
+  L(L &&l, comma, V &&v);
+  L(V &&v);
+  ~L() override {}
+};
+
+struct json_list : json_value, symbol {
+  std::vector<std::unique_ptr<json_value>> values;
+  json_list(lbracket, L &&l, rbracket)
+      : json_value(json_kind::list), values(std::move(l.values)) {}
+  json_list(lbracket, rbracket) : json_value(json_kind::list) {}
+  json_list(json_list &&) = default;
+  ~json_list() override {}
+};
+
+struct V : symbol {
+  std::unique_ptr<json_value> value;
+  V(json_null &&) : value(new json_null) {}
+  V(json_bool &&value) : value(new json_bool(value.value)) {}
+  V(json_number &&value) : value(new json_number(value.value)) {}
+  V(json_string &&value) : value(new json_string(std::move(value))) {}
+  V(json_object &&value)
+      : value(value.members.size() > json_object::linear_lookup_limit
+                  ? new indexed_object(std::move(value))
+                  : new json_object(std::move(value))) {}
+  V(json_list &&value) : value(new json_list(std::move(value))) {}
+  V(error &&) : value(new json_error) {}
+  V(V &&other) = default;
+  ~V() override {}
+};
+
+inline json_member::json_member(string &&name, colon, V &&value)
+    : key(member_names::intern(name.value)), value(std::move(value.value)) {
+  if (key == member_names::npos) {
+    spilled = std::make_unique<std::string>(std::move(name.value));
+  }
+}
+
+inline L::L(L &&l, comma, V &&v) : values(std::move(l.values)) {
+  values.emplace_back(std::move(v.value));
+}
+
+inline L::L(V &&v) { values.emplace_back(std::move(v.value)); }
+
+struct S : symbol {
+  std::unique_ptr<json_value> value;
+  S(V &&value, end) : value(std::move(value.value)) {}
+};
+
+using rule1 = rule<S, V, end>;
+using rule2 = rule<V, json_null>;
+using rule3 = rule<V, json_bool>;
+using rule4 = rule<V, json_number>;
+using rule5 = rule<V, json_string>;
+using rule6 = rule<json_bool, true_>;
+using rule7 = rule<json_bool, false_>;
+using rule8 = rule<json_string, string>;
+using rule9 = rule<json_member, string, colon, V>;
+using rule10 = rule<M, M, comma, json_member>;
+using rule11 = rule<M, json_member>;
+using rule12 = rule<json_object, lbrace, M, rbrace>;
+using rule13 = rule<V, json_object>;
+using rule14 = rule<V, json_list>;
+using rule15 = rule<L, L, comma, V>;
+using rule16 = rule<L, V>;
+using rule17 = rule<json_list, lbracket, L, rbracket>;
+using rule18 = rule<json_list, lbracket, rbracket>;
+using rule19 = rule<json_object, lbrace, rbrace>;
+using rules =
+    set<rule1, rule2, rule3, rule4, rule5, rule6, rule7, rule8, rule9, rule10,
+        rule11, rule12, rule13, rule14, rule15, rule16, rule17, rule18, rule19>;
+using terminals = set<json_null, true_, false_, json_number, string, end, colon,
+                      comma, lbrace, rbrace, lbracket, rbracket>;
+using nonterminals = set<S, V, json_bool, json_string, json_member, M,
+                         json_object, L, json_list>;
+
+// The tables are generated by `table_dump json --header`, so translation units
+// that parse JSON do not construct the automaton. `json_tables_check.cpp`
+// checks that they match the grammar. Define `JSON_COMPUTE_TABLES` to
+// construct them instead, e.g. to generate them again after changing the
+// grammar.
+#if defined(JSON_COMPUTE_TABLES)
+using layout = discovery_order;
+using recovering_layout = discovery_order;
+#else
+using layout = precompiled<tables>;
+using recovering_layout = precompiled<recovering_tables>;
+#endif
+
+using table = transition_table<S, rules, nonterminals, terminals, build_values,
+                               no_instrumentation, layout>;
+
+static_assert(within(table::stats(), {.max_bytes = 32 * 1024}),
+              "JSON table exceeds its size budget");
+
+// A value or member that fails to parse becomes a `json_error`, and parsing
+// resumes at the next comma or closing bracket.
+using rule20 = rule<V, error>;
+using rule21 = rule<json_member, error>;
+using recovering_rules = decltype(join(rules(), set<rule20, rule21>()));
+using recovering_terminals = decltype(join(terminals(), set<error>()));
+
+using recovering_table =
+    transition_table<S, recovering_rules, nonterminals, recovering_terminals,
+                     build_values, no_instrumentation, recovering_layout>;
+
+static_assert(within(recovering_table::stats(), {.max_bytes = 32 * 1024}),
+              "Recovering JSON table exceeds its size budget");
+
+// Position of the first quote at or after `from` that is not escaped by a
+// backslash, or `npos`.
+inline size_t closing_quote(std::string_view text, size_t from) {
+  while ((from = text.find('"', from)) != text.npos) {
+    size_t backslashes = 0;
+    while (backslashes < from && text[from - backslashes - 1] == '\\') {
+      ++backslashes;
+    }
+    if (backslashes % 2 == 0) {
+      return from;
+    }
+    ++from;
+  }
+  return text.npos;
+}
+
+// Appends the contents of a string literal to `out` with its escape
+// sequences decoded, and `\u` escapes encoded as UTF-8. A surrogate that is
+// not part of a pair becomes U+FFFD.
+inline void unescape(std::string_view text, std::string &out) {
+  auto hex = [text](size_t at) {
+    uint32_t code = 0;
+    auto [code_end, error] = std::from_chars(
+        text.data() + std::min(at, text.size()),
+        text.data() + std::min(at + 4, text.size()), code, 16);
+    if (error != std::errc() || code_end != text.data() + at + 4) {
+      throw std::runtime_error("Invalid unicode escape");
+    }
+    return code;
+  };
+  for (size_t at = 0; at < text.size();) {
+    size_t backslash = std::min(text.find('\\', at), text.size());
+    out.append(text, at, backslash - at);
+    if (backslash + 1 >= text.size()) {
+      if (backslash < text.size()) {
+        throw std::runtime_error("Invalid escape sequence");
+      }
+      return;
+    }
+    at = backslash + 2;
+    switch (char c = text[backslash + 1]) {
+    case '"':
+    case '\\':
+    case '/':
+      out += c;
+      break;
+    case 'b':
+      out += '\b';
+      break;
+    case 'f':
+      out += '\f';
+      break;
+    case 'n':
+      out += '\n';
+      break;
+    case 'r':
+      out += '\r';
+      break;
+    case 't':
+      out += '\t';
+      break;
+    case 'u': {
+      uint32_t code = hex(at);
+      at += 4;
+      if (code >= 0xd800 && code < 0xdc00 && text.substr(at, 2) == "\\u") {
+        if (uint32_t low = hex(at + 2); low >= 0xdc00 && low < 0xe000) {
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          at += 6;
+        }
+      }
+      if (code >= 0xd800 && code < 0xe000) {
+        code = 0xfffd;
+      }
+      constexpr uint32_t lead[] = {0, 0xc0, 0xe0, 0xf0};
+      size_t tail = code < 0x80 ? 0 : code < 0x800 ? 1 : code < 0x10000 ? 2 : 3;
+      out += static_cast<char>(lead[tail] | (code >> (6 * tail)));
+      while (tail-- > 0) {
+        out += static_cast<char>(0x80 | ((code >> (6 * tail)) & 0x3f));
+      }
+      break;
+    }
+    default:
+      throw std::runtime_error("Invalid escape sequence");
+    }
+  }
+}
+
+// Length of the JSON number at the start of `text`, or 0 if it does not start
+// with one. Digits after a leading zero, as in `007`, make it no number.
+inline size_t number_length(std::string_view text) {
+  size_t at = text.starts_with('-') ? 1 : 0;
+  auto digits = [text, &at] {
+    size_t from = at;
+    while (at < text.size() && text[at] >= '0' && text[at] <= '9') {
+      ++at;
+    }
+    return at - from;
+  };
+  if (at < text.size() && text[at] == '0') {
+    ++at;
+    if (digits() != 0) {
+      return 0;
+    }
+  } else if (digits() == 0) {
+    return 0;
+  }
+  if (at < text.size() && text[at] == '.') {
+    ++at;
+    if (digits() == 0) {
+      return 0;
+    }
+  }
+  if (at < text.size() && (text[at] == 'e' || text[at] == 'E')) {
+    ++at;
+    if (at < text.size() && (text[at] == '+' || text[at] == '-')) {
+      ++at;
+    }
+    if (digits() == 0) {
+      return 0;
+    }
+  }
+  return at;
+}
+
+// Splits the input into tokens one at a time, so drivers can interleave
+// scanning with parsing and know the byte offset of every token. With
+// `Payloads == false` only `kind<Token>` tags are emitted, for recognizers.
+// String tokens hold their decoded text.
+class lexer {
+  std::string_view input;
+  size_t position = 0;
+  size_t start = 0;
+  // Decoded text of the last string with escape sequences.
+  std::string unescaped;
+
+  template <bool Payloads, typename Token, typename Emit, typename... Args>
+  static void emit_token(Emit &emit, Args &&... args) {
+    if constexpr (Payloads) {
+      emit(Token(std::forward<Args>(args)...));
+    } else {
+      emit(kind<Token>());
+    }
+  }
+
+public:
+  lexer(std::string_view input, size_t position = 0)
+      : input(input), position(position), start(position) {}
+
+  size_t offset() const noexcept { return position; }
+
+  // Start of the last token, or the end of the input once it is exhausted.
+  size_t token_start() const noexcept { return start; }
+
+  template <bool Payloads = true, typename Emit> bool next(Emit &&emit) {
+    while (position < input.size()) {
+      start = position;
+      std::string_view rest = input.substr(position);
+      if (rest.starts_with("null")) {
+        position += 4;
+        emit_token<Payloads, json_null>(emit);
+      } else if (rest[0] == '"') {
+        size_t close = closing_quote(rest, 1);
+        if (close == std::string_view::npos) {
+          throw std::runtime_error("Unterminated string literal");
+        }
+        std::string_view text = rest.substr(1, close - 1);
+        if (text.find('\\') != std::string_view::npos) {
+          unescaped.clear();
+          unescape(text, unescaped);
+          text = unescaped;
+        }
+        position += close + 1;
+        emit_token<Payloads, string>(emit, text);
+      } else if (rest.starts_with("true")) {
+        position += 4;
+        emit_token<Payloads, true_>(emit);
+      } else if (rest.starts_with("false")) {
+        position += 5;
+        emit_token<Payloads, false_>(emit);
+      } else {
+        ++position;
+        switch (rest[0]) {
+        case ' ':
+        case '\t':
+        case '\n':
+        case '\r':
+        case '\f':
+        case '\v':
+          continue;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+          // `from_chars` also takes `inf`, `nan` and leading zeros, so it
+          // only converts what matches the JSON number grammar.
+          size_t length = number_length(rest);
+          double value = 0;
+          auto [number_end, error] =
+              std::from_chars(rest.data(), rest.data() + length, value);
+          if (length == 0 || error != std::errc()) {
+            --position;
+            throw std::runtime_error("Invalid number");
+          }
+          position = start + length;
+          emit_token<Payloads, json_number>(emit, value);
+          break;
+        }
+        case ':':
+          emit_token<Payloads, colon>(emit);
+          break;
+        case ',':
+          emit_token<Payloads, comma>(emit);
+          break;
+        case '{':
+          emit_token<Payloads, lbrace>(emit);
+          break;
+        case '}':
+          emit_token<Payloads, rbrace>(emit);
+          break;
+        case '[':
+          emit_token<Payloads, lbracket>(emit);
+          break;
+        case ']':
+          emit_token<Payloads, rbracket>(emit);
+          break;
+        default:
+          --position;
+          throw std::runtime_error("Invalid character");
+        }
+      }
+      return true;
+    }
+    start = position;
+    return false;
+  }
+};
+
+class scanner {
+  table parse_table;
+  size_t last_error = std::string_view::npos;
+
+public:
+  // Offset of the token that made the last parse fail, or `npos`.
+  size_t error_offset() const noexcept { return last_error; }
+
+  std::unique_ptr<json_value> parse(std::string_view input) {
+    parse_table.reset();
+    last_error = std::string_view::npos;
+    lexer tokens(input);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &e) {
+      last_error = tokens.token_start();
+      std::cout << e.what() << " at offset " << last_error << '\n';
+      return {};
+    }
+    return std::move(parse_table.get_parse_result().value);
+  }
+};
+
+// Parses a batch document in one pass. Every malformed value or member is
+// replaced by a `json_error` and reported in `diagnostics`, with the offset
+// of the token that could not be parsed.
+class batch_scanner {
+  recovering_table parse_table;
+
+  // Skips an invalid character or unterminated string up to the next
+  // whitespace or structural character, and reports it as an `error`.
+  void skip_invalid(std::string_view input, lexer &tokens) {
+    size_t offset = tokens.token_start();
+    parse_table.recovery.position = offset;
+    parse_table.recovery.report(parse_table.stack.back(),
+                                recovering_table::error_idx);
+    parse_table.read_token(error());
+    size_t resume = input.find_first_of(" \t\n\r,:[]{}", offset + 1);
+    tokens = lexer(input, std::min(resume, input.size()));
+  }
+
+public:
+  std::vector<diagnostic> const &diagnostics() const noexcept {
+    return parse_table.recovery.entries;
+  }
+
+  // All errors, including those beyond the diagnostics limit.
+  size_t num_errors() const noexcept { return parse_table.recovery.total; }
+
+  std::unique_ptr<json_value> parse(std::string_view input) {
+    parse_table.reset();
+    lexer tokens(input);
+    try {
+      bool parsing = false;
+      while (true) {
+        try {
+          if (!tokens.next([this, &tokens, &parsing](auto &&token) {
+                parsing = true;
+                parse_table.recovery.position = tokens.token_start();
+                parse_table.read_token(std::move(token));
+                parsing = false;
+              })) {
+            break;
+          }
+        } catch (std::exception const &) {
+          if (parsing) {
+            throw;
+          }
+          skip_invalid(input, tokens);
+        }
+      }
+      parse_table.recovery.position = input.size();
+      parse_table.read_token(end());
+      return std::move(parse_table.get_parse_result().value);
+    } catch (std::exception const &e) {
+      std::cout << e.what() << " at offset " << tokens.token_start() << '\n';
+      return {};
+    }
+  }
+};
+
+// Checks the syntax of a document without building any values.
+template <typename Layout = layout> class basic_validator {
+  transition_table<S, rules, nonterminals, terminals, recognize,
+                   no_instrumentation, Layout>
+      parse_table;
+
+public:
+  // Returns the offset of the first rejected token, like
+  // `scanner::error_offset`, or `npos` if the input is valid.
+  size_t validate(std::string_view input) {
+    parse_table.reset();
+    lexer tokens(input);
+    try {
+      while (tokens.next<false>(
+          [this](auto token) { parse_table.read_token(token); })) {
+      }
+      parse_table.read_token(kind<end>());
+    } catch (std::exception const &) {
+      return tokens.token_start();
+    }
+    return std::string_view::npos;
+  }
+};
+
+using validator = basic_validator<>;
+
+// States and columns ordered by the lookups of `parser_bench`'s corpora.
+using profiled_validator = basic_validator<profile_guided<profile>>;
+
+// Translates the shifts and reductions of the JSON grammar into the events
+// `on_null`, `on_bool`, `on_number`, `on_string`, `on_key`, `on_start_object`,
+// `on_end_object`, `on_start_list` and `on_end_list` of `Handler`.
+template <typename Handler> struct sax_adapter {
+  Handler handler;
+  std::string pending;
+
+  void shift(json_null &&) { handler.on_null(); }
+  void shift(true_ &&) { handler.on_bool(true); }
+  void shift(false_ &&) { handler.on_bool(false); }
+  void shift(json_number &&number) { handler.on_number(number.value); }
+  void shift(string &&str) { pending = std::move(str.value); }
+  void shift(colon &&) { handler.on_key(pending); }
+  void shift(lbrace &&) { handler.on_start_object(); }
+  void shift(rbrace &&) { handler.on_end_object(); }
+  void shift(lbracket &&) { handler.on_start_list(); }
+  void shift(rbracket &&) { handler.on_end_list(); }
+  template <typename Token> void shift(Token &&) {}
+
+  void reduce(rule8) { handler.on_string(pending); }
+  template <typename Rule> void reduce(Rule) {}
+};
+
+template <typename Handler> class sax_scanner {
+  transition_table<S, rules, nonterminals, terminals,
+                   events<sax_adapter<Handler>>, no_instrumentation, layout>
+      parse_table;
+
+public:
+  Handler &handler() noexcept { return parse_table.handler.handler; }
+
+  bool parse(std::string_view input) {
+    parse_table.reset();
+    lexer tokens(input);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+      parse_table.finish();
+    } catch (std::exception const &e) {
+      std::cout << e.what() << '\n';
+      return false;
+    }
+    return true;
+  }
+};
+
+// Parses one large document by cutting its top level list or object at
+// commas and parsing the pieces on separate threads.
+class parallel_scanner {
+  table parse_table;
+  speculative_parser<table, lexer, V, comma> lists;
+  speculative_parser<table, lexer, json_member, comma> objects;
+  std::vector<size_t> list_context =
+      predict_context<table>(lbracket(), json_null(), comma());
+  std::vector<size_t> object_context = predict_context<table>(
+      lbrace(), string(""), colon(), json_null(), comma());
+
+public:
+  explicit parallel_scanner(
+      size_t num_threads = std::thread::hardware_concurrency(),
+      size_t min_segment_size = 1 << 16)
+      : lists(',', num_threads, min_segment_size),
+        objects(',', num_threads, min_segment_size) {}
+
+  std::unique_ptr<json_value> parse(std::string_view input) {
+    parse_table.reset();
+    try {
+      size_t first = input.find_first_not_of(" \t\n\r\f\v");
+      if (first != std::string_view::npos && input[first] == '{') {
+        objects.parse(parse_table, input, object_context);
+      } else {
+        lists.parse(parse_table, input, list_context);
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &e) {
+      std::cout << e.what() << '\n';
+      return {};
+    }
+    return std::move(parse_table.get_parse_result().value);
+  }
+};
+
+// Marks the bytes in `chars`.
+constexpr std::array<bool, 256> char_set(std::string_view chars) {
+  std::array<bool, 256> result{};
+  for (unsigned char c : chars) {
+    result[c] = true;
+  }
+  return result;
+}
+
+// Builds values only for the subtrees at a fixed set of paths, like
+// `user.name` or `items[2].id`, and skips everything else by matching
+// brackets and jumping over strings to their first unescaped quote, without
+// running the grammar. Skipped values are only checked for balanced brackets
+// and terminated strings, and the scan stops once every path has been found.
+// Member names are compared after decoding their escape sequences, but names
+// that contain `.` or `[` cannot be selected.
+class projecting_scanner {
+  static constexpr size_t none = std::string_view::npos;
+
+  // A step of one or more paths, with the steps that follow it by member
+  // name or list index, and the path that ends in it. Only the first member
+  // with a name is visited, like in `json_object::find`.
+  struct step {
+    std::vector<std::pair<std::string, size_t>> members;
+    std::vector<std::pair<size_t, size_t>> elements;
+    size_t target = none;
+    size_t visited = 0;
+  };
+
+  // Characters that end a run of skipped characters inside brackets, and
+  // those that end a number or literal.
+  static constexpr std::array<bool, 256> structural = char_set("\"[]{}");
+  static constexpr std::array<bool, 256> delimiter =
+      char_set(" \t\n\r\f\v,:]}");
+
+  std::vector<step> steps = std::vector<step>(1);
+  table parse_table;
+  std::string_view input;
+  size_t position = 0;
+  size_t remaining = 0;
+  size_t generation = 0;
+  size_t last_error = none;
+  std::vector<std::unique_ptr<json_value>> values;
+  // Decoded text of the last member name with escape sequences.
+  std::string unescaped_name;
+
+  template <typename Key>
+  size_t next_step(std::vector<std::pair<Key, size_t>> step::*children,
+                   size_t from, Key key) {
+    for (auto &[child_key, child] : steps[from].*children) {
+      if (child_key == key) {
+        return child;
+      }
+    }
+    steps.emplace_back();
+    (steps[from].*children).emplace_back(std::move(key), steps.size() - 1);
+    return steps.size() - 1;
+  }
+
+  void skip_space() {
+    while (position < input.size() && (input[position] == ' ' ||
+                                       (input[position] >= '\t' &&
+                                        input[position] <= '\r'))) {
+      ++position;
+    }
+  }
+
+  void expect(char c, char const *message) {
+    skip_space();
+    if (position >= input.size() || input[position] != c) {
+      throw std::runtime_error(message);
+    }
+    ++position;
+  }
+
+  // Moves behind the value at `position`.
+  void skip_value() {
+    skip_space();
+    size_t depth = 0;
+    do {
+      if (position >= input.size()) {
+        throw std::runtime_error("Unexpected end of input");
+      }
+      switch (input[position]) {
+      case '"': {
+        size_t close = closing_quote(input, position + 1);
+        if (close == none) {
+          throw std::runtime_error("Unterminated string literal");
+        }
+        position = close + 1;
+        break;
+      }
+      case '{':
+      case '[':
+        ++depth;
+        ++position;
+        break;
+      case '}':
+      case ']':
+        if (depth == 0) {
+          throw std::runtime_error("Expected a value");
+        }
+        --depth;
+        ++position;
+        break;
+      default:
+        if (depth == 0 && delimiter[static_cast<unsigned char>(
+                              input[position])]) {
+          throw std::runtime_error("Expected a value");
+        }
+        auto const &stop = depth > 0 ? structural : delimiter;
+        while (++position < input.size() &&
+               !stop[static_cast<unsigned char>(input[position])]) {
+        }
+      }
+    } while (depth > 0);
+  }
+
+  // Parses the value between `begin` and `position` with the grammar.
+  std::unique_ptr<json_value> build(size_t begin) {
+    parse_table.reset();
+    lexer tokens(input.substr(0, position), begin);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &) {
+      position = tokens.token_start();
+      throw;
+    }
+    return std::move(parse_table.get_parse_result().value);
+  }
+
+  // Moves behind the separator after a member or element, and returns
+  // whether another one follows.
+  bool next_in(char close, char const *message) {
+    skip_space();
+    if (position >= input.size()) {
+      throw std::runtime_error("Unexpected end of input");
+    }
+    char c = input[position++];
+    if (c != ',' && c != close) {
+      --position;
+      throw std::runtime_error(message);
+    }
+    return c == ',';
+  }
+
+  void object(step const &current) {
+    expect('{', "Expected an object");
+    skip_space();
+    if (position < input.size() && input[position] == '}') {
+      ++position;
+      return;
+    }
+    do {
+      expect('"', "Expected a member name");
+      size_t close = closing_quote(input, position);
+      if (close == none) {
+        throw std::runtime_error("Unterminated string literal");
+      }
+      std::string_view name = input.substr(position, close - position);
+      if (name.find('\\') != none) {
+        unescaped_name.clear();
+        unescape(name, unescaped_name);
+        name = unescaped_name;
+      }
+      position = close + 1;
+      expect(':', "Expected ':'");
+      size_t child = none;
+      for (auto &[member, next] : current.members) {
+        if (member == name && steps[next].visited != generation) {
+          child = next;
+          break;
+        }
+      }
+      child == none ? skip_value() : value(child);
+      if (remaining == 0) {
+        return;
+      }
+    } while (next_in('}', "Expected ',' or '}'"));
+  }
+
+  void list(step const &current) {
+    expect('[', "Expected a list");
+    skip_space();
+    if (position < input.size() && input[position] == ']') {
+      ++position;
+      return;
+    }
+    size_t index = 0;
+    do {
+      size_t child = none;
+      for (auto &[element, next] : current.elements) {
+        if (element == index) {
+          child = next;
+          break;
+        }
+      }
+      child == none ? skip_value() : value(child);
+      if (remaining == 0) {
+        return;
+      }
+      ++index;
+    } while (next_in(']', "Expected ',' or ']'"));
+  }
+
+  void value(size_t index) {
+    step &current = steps[index];
+    current.visited = generation;
+    skip_space();
+    size_t begin = position;
+    char c = position < input.size() ? input[position] : '\0';
+    if (c == '{' && !current.members.empty()) {
+      object(current);
+    } else if (c == '[' && !current.elements.empty()) {
+      list(current);
+    } else {
+      skip_value();
+    }
+    if (current.target != none && !values[current.target]) {
+      values[current.target] = build(begin);
+      --remaining;
+    }
+  }
+
+public:
+  // Paths are member names separated by `.`, and list indices in brackets.
+  // The empty path selects the whole document.
+  explicit projecting_scanner(std::vector<std::string_view> const &paths)
+      : values(paths.size()) {
+    for (size_t i = 0; i < paths.size(); ++i) {
+      std::string_view path = paths[i];
+      size_t current = 0;
+      for (size_t at = 0; at < path.size();) {
+        if (path[at] == '[') {
+          size_t close = path.find(']', at);
+          size_t index = 0;
+          auto [index_end, error] = std::from_chars(
+              path.data() + at + 1, path.data() + std::min(close, path.size()),
+              index);
+          if (close == none || error != std::errc() ||
+              index_end != path.data() + close) {
+            throw std::runtime_error("Invalid list index in path");
+          }
+          current = next_step(&step::elements, current, index);
+          at = close + 1;
+        } else {
+          at += path[at] == '.' && at > 0;
+          size_t name_end = std::min(path.find_first_of(".[", at), path.size());
+          current = next_step(&step::members, current,
+                              std::string(path.substr(at, name_end - at)));
+          at = name_end;
+        }
+      }
+      if (steps[current].target != none) {
+        throw std::runtime_error("Duplicate path");
+      }
+      steps[current].target = i;
+    }
+  }
+
+  // Offset at which the last parse failed, or `npos`.
+  size_t error_offset() const noexcept { return last_error; }
+
+  // Returns the value at every path in order, or `nullptr` for paths that
+  // are not in `document`. If parsing fails, all values are `nullptr`.
+  std::vector<std::unique_ptr<json_value>> &parse(std::string_view document) {
+    input = document;
+    position = 0;
+    last_error = none;
+    remaining = values.size();
+    ++generation;
+    for (auto &value : values) {
+      value.reset();
+    }
+    try {
+      if (remaining > 0) {
+        value(0);
+      }
+    } catch (std::exception const &e) {
+      last_error = position;
+      std::cout << e.what() << " at offset " << last_error << '\n';
+      for (auto &value : values) {
+        value.reset();
+      }
+    }
+    return values;
+  }
+};
+
+// Keeps the values of a top level list across edits of the document.
+class incremental_list
+    : public incremental_parser<table, lexer, lbracket, V, comma, rbracket> {
+public:
+  incremental_list()
+      : incremental_parser(
+            predict_context<json::table>(lbracket(), json_null(), comma())) {}
+};
+
+// Keeps the members of a top level object across edits of the document.
+class incremental_object
+    : public incremental_parser<table, lexer, lbrace, json_member, comma,
+                                rbrace> {
+public:
+  incremental_object()
+      : incremental_parser(predict_context<json::table>(
+            lbrace(), string(""), colon(), json_null(), comma())) {}
+};
+
+} // namespace json
+
+#endif
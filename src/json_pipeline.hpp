@@ -0,0 +1,198 @@
+#if !defined(JSON_PIPELINE_HPP)
+#define JSON_PIPELINE_HPP
+
+#include <array>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json_grammar.hpp"
+#include "parser.hpp"
+#include "pipeline.hpp"
+
+namespace json {
+
+using token = decltype(to_variant(terminals()));
+
+// Parses one document from a file descriptor in three stages: reading into
+// two buffers in turn, tokenizing, and running the table. The stages are
+// connected by bounded queues, so reading the next chunk, scanning this one
+// and parsing the tokens of the last one overlap when every stage has a
+// thread of its own. On one thread they take turns whenever a queue runs
+// full or empty. Tokens are handed over in batches that go back and forth
+// like the buffers, so the queues are touched once per batch and nothing is
+// allocated for them after the first parse. The result and error offsets are
+// the same as `scanner`'s for the whole input.
+class pipeline_scanner {
+  static constexpr size_t num_buffers = 2;
+  static constexpr size_t num_batches = 4;
+  static constexpr size_t batch_size = 256;
+  // Characters after which a number or literal cannot go on.
+  static constexpr std::string_view delimiters = " \t\n\r\f\v,:[]{}\"";
+  static constexpr std::array<bool, 256> delimiter = char_set(delimiters);
+
+  table parse_table;
+  std::array<std::vector<char>, num_buffers> buffers;
+  spsc_queue<size_t, num_buffers> free_buffers;
+  spsc_queue<chunk, num_buffers> chunks;
+  std::array<std::vector<located<token>>, num_batches> batches;
+  spsc_queue<size_t, num_batches> free_batches;
+  spsc_queue<size_t, num_batches> full_batches;
+  // Input of earlier chunks that did not end in a complete token.
+  std::string pending;
+  // What the lexer threw. The tokenizer ends the token stream at the invalid
+  // token instead, so that errors are reported in input order.
+  std::exception_ptr lexical_error;
+  size_t last_error = std::string_view::npos;
+  std::unique_ptr<json_value> result;
+
+  // Whether more input could complete the token at the start of `rest`, or
+  // make it valid.
+  static bool incomplete(std::string_view rest) {
+    return rest[0] == '"' || rest.find_first_of(delimiters) == rest.npos;
+  }
+
+  // Whether the token that ends at `after` is complete without more input.
+  static bool complete(std::string_view text, size_t after) {
+    return (after < text.size() &&
+            delimiter[static_cast<unsigned char>(text[after])]) ||
+           text.find_first_of(delimiters, after) != text.npos;
+  }
+
+  // Emits every token that is complete before the next chunk arrives. A
+  // token at the end of a chunk is kept in `pending` with the input behind
+  // it, since the next chunk may continue it.
+  stage tokenize() {
+    size_t base = 0;
+    size_t batch = co_await free_batches.pop();
+    while (true) {
+      chunk next = co_await chunks.pop();
+      bool last = next.text.empty();
+      std::string_view text = next.text;
+      if (!pending.empty()) {
+        pending.append(text);
+        text = pending;
+      }
+      lexer scan(text);
+      size_t consumed = text.size();
+      while (true) {
+        auto &out = batches[batch];
+        auto keep = [&](auto &&t) {
+          out.emplace_back(std::move(t), base + scan.token_start());
+        };
+        try {
+          if (!scan.next(keep)) {
+            break;
+          }
+        } catch (std::exception const &) {
+          if (last || !incomplete(text.substr(scan.token_start()))) {
+            lexical_error = std::current_exception();
+          }
+          consumed = scan.token_start();
+          break;
+        }
+        if (!last && !complete(text, scan.offset())) {
+          out.pop_back();
+          consumed = scan.token_start();
+          break;
+        }
+        if (out.size() == batch_size) {
+          co_await full_batches.push(std::move(batch));
+          batch = co_await free_batches.pop();
+        }
+      }
+      base += consumed;
+      if (text.data() == pending.data()) {
+        pending.erase(0, consumed);
+      } else {
+        pending.assign(text.substr(consumed));
+      }
+      co_await free_buffers.push(std::move(next.buffer));
+      if (last || lexical_error) {
+        batches[batch].emplace_back(end(), base);
+        co_await full_batches.push(std::move(batch));
+        co_return;
+      }
+    }
+  }
+
+  stage build() {
+    while (true) {
+      size_t batch = co_await full_batches.pop();
+      for (auto &next : batches[batch]) {
+        bool done = std::holds_alternative<end>(next.token);
+        try {
+          if (done && lexical_error) {
+            std::rethrow_exception(lexical_error);
+          }
+          std::visit(
+              [this](auto &t) { parse_table.read_token(std::move(t)); },
+              next.token);
+        } catch (std::exception const &) {
+          last_error = next.offset;
+          throw;
+        }
+        if (done) {
+          result = std::move(parse_table.get_parse_result().value);
+          co_return;
+        }
+      }
+      batches[batch].clear();
+      co_await free_batches.push(std::move(batch));
+    }
+  }
+
+public:
+  explicit pipeline_scanner(size_t buffer_size = 1 << 16) {
+    for (auto &buffer : buffers) {
+      buffer.resize(buffer_size);
+    }
+    for (auto &batch : batches) {
+      batch.reserve(batch_size);
+    }
+  }
+
+  // Offset of the token that made the last parse fail, or `npos`.
+  size_t error_offset() const noexcept { return last_error; }
+
+  std::unique_ptr<json_value> parse(int fd,
+                                    placement where = placement::one_thread) {
+    parse_table.reset();
+    free_buffers.clear();
+    chunks.clear();
+    free_batches.clear();
+    full_batches.clear();
+    pending.clear();
+    lexical_error = nullptr;
+    last_error = std::string_view::npos;
+    for (size_t i = 0; i < num_buffers; ++i) {
+      free_buffers.try_push(size_t{i});
+    }
+    for (size_t i = 0; i < num_batches; ++i) {
+      batches[i].clear();
+      free_batches.try_push(size_t{i});
+    }
+    std::array<stage, 3> stages{read_chunks(fd, buffers, free_buffers, chunks),
+                                tokenize(), build()};
+    try {
+      run(stages, where);
+    } catch (std::exception const &e) {
+      std::cout << e.what();
+      if (error_offset() != std::string_view::npos) {
+        std::cout << " at offset " << error_offset();
+      }
+      std::cout << '\n';
+      return {};
+    }
+    return std::move(result);
+  }
+};
+
+} // namespace json
+
+#endif
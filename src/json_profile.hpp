@@ -0,0 +1,27 @@
+// Generated by `parser_bench --write-profile`: table lookups of the JSON
+// grammar on the benchmark corpora, see `parser::profile_guided`.
+#if !defined(JSON_PROFILE_HPP)
+#define JSON_PROFILE_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace json {
+
+struct profile {
+  static constexpr std::array<uint64_t, 29> states = {
+      512, 256, 0, 0, 0, 0,
+      0, 0, 0, 0, 0, 0,
+      503184, 0, 394769, 572708, 286354, 394769,
+      486705, 394769, 508787, 0, 419596, 346628,
+      327468, 92128, 0, 108415, 0};
+  static constexpr std::array<uint64_t, 21> symbols = {
+      72942, 36705, 36647, 362575, 499978, 512,
+      394769, 1513614, 108415, 325245, 92128, 184384,
+      0, 0, 0, 0, 394769, 286354,
+      108415, 327468, 92128};
+};
+
+} // namespace json
+
+#endif
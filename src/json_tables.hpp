@@ -0,0 +1,240 @@
+// Generated by `table_dump json --header`: the parse tables of the JSON
+// grammar, see `parser::precompiled`.
+#if !defined(JSON_TABLES_HPP)
+#define JSON_TABLES_HPP
+
+#include <array>
+#include <cstddef>
+
+#include "parser.hpp"
+
+namespace json {
+
+struct tables {
+  using enum parser::action_type;
+
+  static constexpr std::array<std::array<parser::action, 12>, 29>
+      actions = {{
+          {{{Shift, 1, 1}, {Shift, 1, 2, 1}, {Shift, 1, 2, 2}, {Shift, 1, 1, 3},
+            {Shift, 1, 2, 4}, {}, {}, {}, {Shift, 12}, {}, {Shift, 20}, {}}},
+          {{{}, {}, {}, {}, {}, {Shift, 2}, {}, {}, {}, {}, {}, {}}},
+          {{{Accept}, {Accept}, {Accept}, {Accept}, {Accept}, {Accept},
+            {Accept}, {Accept}, {Accept}, {Accept}, {Accept}, {Accept}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {Shift, 17}, {}, {}, {}, {}, {Shift, 28}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {Shift, 15}, {}, {Shift, 27}, {}, {}}},
+          {{{}, {}, {}, {}, {Shift, 17}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}}},
+          {{{}, {}, {}, {}, {}, {}, {Shift, 18}, {}, {}, {}, {}, {}}},
+          {{{Shift, 19, 1}, {Shift, 19, 2, 1}, {Shift, 19, 2, 2},
+            {Shift, 19, 1, 3}, {Shift, 19, 2, 4}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {}}},
+          {{{Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}}},
+          {{{Shift, 22, 2, 10}, {Shift, 22, 3, 11}, {Shift, 22, 3, 12},
+            {Shift, 22, 2, 13}, {Shift, 22, 3, 14}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {Shift, 26}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {Shift, 23}, {}, {}, {}, {Shift, 25}}},
+          {{{Shift, 24, 1}, {Shift, 24, 2, 1}, {Shift, 24, 2, 2},
+            {Shift, 24, 1, 3}, {Shift, 24, 2, 4}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {}}},
+          {{{Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}}},
+          {{{Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}}},
+          {{{Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}}},
+          {{{Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}}},
+          {{{Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}}}}};
+  static constexpr std::array<std::array<parser::action, 29>, 9>
+      gotos = {{
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {Goto, 19}, {}, {Goto, 22, 1, 15}, {}, {}, {Goto, 24},
+            {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 5}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 5}, {}, {Goto, 22, 2, 16}, {}, {},
+            {Goto, 24, 1, 5}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 6}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 6}, {}, {Goto, 22, 2, 17}, {}, {},
+            {Goto, 24, 1, 6}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {Goto, 14, 1, 9},
+            {}, {}, {Goto, 16}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {Goto, 14}, {}, {},
+            {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 7}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 7}, {}, {Goto, 22, 2, 18}, {}, {},
+            {Goto, 24, 1, 7}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {Goto, 22}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 8}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 8}, {}, {Goto, 22, 2, 19}, {}, {},
+            {Goto, 24, 1, 8}, {}, {}, {}, {}, {}}}}};
+  static constexpr std::array<size_t, 35> unit_chains = {1, 5, 2, 6, 2, 3, 7, 4,
+      2, 4, 12, 13, 10, 1, 15, 5, 2, 15, 6, 2, 15, 3, 15, 7, 4, 15, 15, 2, 15,
+      4, 15, 12, 15, 13, 15};
+  static constexpr std::array<size_t, 21> chain_offsets = {0, 1, 3, 5, 6, 8, 9,
+      10, 11, 12, 13, 15, 18, 21, 23, 26, 27, 29, 31, 33, 35};
+  static constexpr std::array<size_t, 29> state_order = {0, 1, 2, 3, 4, 5, 6, 7,
+      8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26,
+      27, 28};
+  static constexpr std::array<size_t, 12> terminal_order = {0, 1, 2, 3, 4, 5, 6,
+      7, 8, 9, 10, 11};
+  static constexpr std::array<size_t, 9> nonterminal_order = {0, 1, 2, 3, 4, 5,
+      6, 7, 8};
+  static constexpr parser::table_stats stats = {29, 12, 9, 19, 19488, 609, 158,
+      3, false};
+};
+
+struct recovering_tables {
+  using enum parser::action_type;
+
+  static constexpr std::array<std::array<parser::action, 13>, 31>
+      actions = {{
+          {{{Shift, 1, 1}, {Shift, 1, 2, 1}, {Shift, 1, 2, 2}, {Shift, 1, 1, 3},
+            {Shift, 1, 2, 4}, {}, {}, {}, {Shift, 12}, {}, {Shift, 20}, {},
+            {Shift, 1, 1, 5}}},
+          {{{}, {}, {}, {}, {}, {Shift, 2}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Accept}, {Accept}, {Accept}, {Accept}, {Accept}, {Accept},
+            {Accept}, {Accept}, {Accept}, {Accept}, {Accept}, {Accept},
+            {Accept}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {Shift, 17}, {}, {}, {}, {}, {Shift, 30}, {}, {},
+            {Shift, 14, 2, 10}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {Shift, 15}, {}, {Shift, 29}, {}, {},
+            {}}},
+          {{{}, {}, {}, {}, {Shift, 17}, {}, {}, {}, {}, {}, {}, {},
+            {Shift, 16, 1, 12}}},
+          {{{Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9}, {Reduce, 5, 3, 9},
+            {Reduce, 5, 3, 9}}},
+          {{{}, {}, {}, {}, {}, {}, {Shift, 18}, {}, {}, {}, {}, {}, {}}},
+          {{{Shift, 19, 1}, {Shift, 19, 2, 1}, {Shift, 19, 2, 2},
+            {Shift, 19, 1, 3}, {Shift, 19, 2, 4}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {}, {Shift, 19, 1, 5}}},
+          {{{Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8}, {Reduce, 4, 3, 8},
+            {Reduce, 4, 3, 8}}},
+          {{{Shift, 22, 2, 13}, {Shift, 22, 3, 14}, {Shift, 22, 3, 15},
+            {Shift, 22, 2, 16}, {Shift, 22, 3, 17}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {Shift, 27}, {Shift, 22, 2, 18}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {Shift, 23}, {}, {}, {}, {Shift, 26},
+            {}}},
+          {{{Shift, 24, 1}, {Shift, 24, 2, 1}, {Shift, 24, 2, 2},
+            {Shift, 24, 1, 3}, {Shift, 24, 2, 4}, {}, {}, {}, {Shift, 12}, {},
+            {Shift, 20}, {}, {Shift, 24, 1, 5}}},
+          {{{Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14}, {Reduce, 7, 3, 14},
+            {Reduce, 7, 3, 14}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16}, {Reduce, 8, 3, 16},
+            {Reduce, 8, 3, 16}}},
+          {{{Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17}, {Reduce, 8, 2, 17},
+            {Reduce, 8, 2, 17}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11}, {Reduce, 6, 3, 11},
+            {Reduce, 6, 3, 11}}},
+          {{{Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18}, {Reduce, 6, 2, 18},
+            {Reduce, 6, 2, 18}}}}};
+  static constexpr std::array<std::array<parser::action, 31>, 9>
+      gotos = {{
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {Goto, 19}, {}, {Goto, 22, 1, 19}, {}, {}, {Goto, 24},
+            {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 6}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 6}, {}, {Goto, 22, 2, 20}, {}, {},
+            {Goto, 24, 1, 6}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 7}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 7}, {}, {Goto, 22, 2, 21}, {}, {},
+            {Goto, 24, 1, 7}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {Goto, 14, 1, 11},
+            {}, {}, {Goto, 16}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {Goto, 14}, {}, {},
+            {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 8}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 8}, {}, {Goto, 22, 2, 22}, {}, {},
+            {Goto, 24, 1, 8}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {Goto, 22}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}}},
+          {{{Goto, 1, 1, 9}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, {},
+            {}, {}, {}, {}, {Goto, 19, 1, 9}, {}, {Goto, 22, 2, 23}, {}, {},
+            {Goto, 24, 1, 9}, {}, {}, {}, {}, {}, {}, {}}}}};
+  static constexpr std::array<size_t, 41> unit_chains = {1, 5, 2, 6, 2, 3, 7, 4,
+      19, 2, 4, 12, 13, 20, 10, 10, 20, 1, 15, 5, 2, 15, 6, 2, 15, 3, 15, 7, 4,
+      15, 19, 15, 15, 2, 15, 4, 15, 12, 15, 13, 15};
+  static constexpr std::array<size_t, 25> chain_offsets = {0, 1, 3, 5, 6, 8, 9,
+      10, 11, 12, 13, 15, 16, 17, 19, 22, 25, 27, 30, 32, 33, 35, 37, 39, 41};
+  static constexpr std::array<size_t, 31> state_order = {0, 1, 2, 3, 4, 5, 6, 7,
+      8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26,
+      27, 28, 29, 30};
+  static constexpr std::array<size_t, 13> terminal_order = {0, 1, 2, 3, 4, 5, 6,
+      7, 8, 9, 10, 11, 12};
+  static constexpr std::array<size_t, 9> nonterminal_order = {0, 1, 2, 3, 4, 5,
+      6, 7, 8};
+  static constexpr parser::table_stats stats = {31, 13, 9, 21, 21824, 682, 172,
+      3, false};
+};
+
+} // namespace json
+
+#endif
@@ -0,0 +1,18 @@
+#include "json_grammar.hpp"
+
+using namespace parser;
+
+#if !defined(JSON_COMPUTE_TABLES)
+// Every target that parses JSON builds this translation unit, which is the
+// one that constructs the JSON automaton, so a change to the grammar fails
+// the build until `json_tables.hpp` is generated again.
+static_assert(
+    same_tables<parse_table<json::S, json::rules, json::nonterminals,
+                            json::terminals>,
+                json::table>() &&
+        same_tables<parse_table<json::S, json::recovering_rules,
+                                json::nonterminals, json::recovering_terminals>,
+                    json::recovering_table>(),
+    "json_tables.hpp is out of date, build with JSON_COMPUTE_TABLES "
+    "and run `table_dump json --header src/json_tables.hpp`");
+#endif
@@ -0,0 +1,183 @@
+#if !defined(JSON_TREE_HPP)
+#define JSON_TREE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "json_grammar.hpp"
+#include "parser.hpp"
+
+// JSON values as plain recursive types, parsed in variant mode. Children are
+// kept in `std::vector`s, which accept incomplete element types, so `value`
+// can contain objects and lists of itself without a common base class. The
+// table stores its values in one `std::variant` stack without an arena or
+// `dynamic_cast`, and only strings, members and elements allocate.
+namespace json::tree {
+
+struct member;
+struct value;
+struct M;
+struct L;
+
+struct object {
+  std::vector<member> members;
+  object(lbrace, M &&m, rbrace);
+  object(lbrace, rbrace) {}
+  object(object &&other) noexcept
+      : members(std::move(other.members)),
+        index(other.index.exchange(nullptr)) {}
+  object &operator=(object &&other) noexcept {
+    members = std::move(other.members);
+    delete index.exchange(other.index.exchange(nullptr));
+    return *this;
+  }
+  ~object() { delete index.load(std::memory_order_relaxed); }
+
+  // Value of the first member named `name`, or `nullptr`. Like
+  // `json_object::find`, objects with more than `linear_lookup_limit`
+  // members are indexed on the first call.
+  value const *find(std::string_view name) const;
+
+  // Drops the index, which has to happen after changing `members`.
+  void reindex() { delete index.exchange(nullptr); }
+
+private:
+  // Only set for large objects. The pointer costs a `value` nothing, which is
+  // as large as its `std::string` alternative anyway.
+  mutable std::atomic<member_index const *> index{nullptr};
+};
+
+struct list {
+  std::vector<value> values;
+  list(lbracket, L &&l, rbracket);
+  list(lbracket, rbracket) {}
+};
+
+struct value {
+  std::variant<std::nullptr_t, bool, double, std::string, object, list> data;
+
+  value(json_null &&) : data(nullptr) {}
+  value(true_ &&) : data(true) {}
+  value(false_ &&) : data(false) {}
+  value(json_number &&number) : data(number.value) {}
+  value(string &&str) : data(std::move(str.value)) {}
+  value(object &&o) : data(std::move(o)) {}
+  value(list &&l) : data(std::move(l)) {}
+};
+
+struct member {
+  uint32_t key = member_names::npos;
+  value data;
+  // The name if the interner was full, like `json_member::spilled`.
+  std::unique_ptr<std::string> spilled;
+  member(string &&name, colon, value &&data)
+      : key(member_names::intern(name.value)), data(std::move(data)) {
+    if (key == member_names::npos) {
+      spilled = std::make_unique<std::string>(std::move(name.value));
+    }
+  }
+
+  std::string_view name() const {
+    return spilled ? std::string_view(*spilled) : member_names::name(key);
+  }
+};
+
+inline value const *object::find(std::string_view name) const {
+  uint32_t key = member_names::find(name);
+  if (key != member_names::npos &&
+      members.size() > json_object::linear_lookup_limit) {
+    size_t position = member_index::of(index, members).find(key);
+    return position < members.size() ? &members[position].data : nullptr;
+  }
+  for (auto &m : members) {
+    if (key != member_names::npos ? m.key == key
+                                  : m.spilled && *m.spilled == name) {
+      return &m.data;
+    }
+  }
+  return nullptr;
+}
+
+// Members and elements of an object or list that is still being parsed.
+struct M {
+  std::vector<member> members;
+  M(member &&m) { members.push_back(std::move(m)); }
+  M(M &&m, comma, member &&next) : members(std::move(m.members)) {
+    members.push_back(std::move(next));
+  }
+};
+
+struct L {
+  std::vector<value> values;
+  L(value &&v) { values.push_back(std::move(v)); }
+  L(L &&l, comma, value &&v) : values(std::move(l.values)) {
+    values.push_back(std::move(v));
+  }
+};
+
+inline object::object(lbrace, M &&m, rbrace) : members(std::move(m.members)) {}
+
+inline list::list(lbracket, L &&l, rbracket) : values(std::move(l.values)) {}
+
+struct document {
+  value root;
+  document(value &&root, end) : root(std::move(root)) {}
+};
+
+using rules =
+    set<rule<document, value, end>, rule<value, json_null>,
+        rule<value, true_>, rule<value, false_>, rule<value, json_number>,
+        rule<value, string>, rule<value, object>, rule<value, list>,
+        rule<member, string, colon, value>, rule<M, member>,
+        rule<M, M, comma, member>, rule<object, lbrace, M, rbrace>,
+        rule<object, lbrace, rbrace>, rule<L, value>,
+        rule<L, L, comma, value>, rule<list, lbracket, L, rbracket>,
+        rule<list, lbracket, rbracket>>;
+using nonterminals = set<document, value, member, M, object, L, list>;
+
+using table = transition_table<document, rules, nonterminals, terminals>;
+
+static_assert(!all_symbols(table::symbols()),
+              "The JSON tree has to be parsed in variant mode");
+static_assert(within(table::stats(), {.max_bytes = 32 * 1024}),
+              "JSON tree table exceeds its size budget");
+
+// Like `json::scanner`, for `tree::value`s.
+class scanner {
+  table parse_table;
+  size_t last_error = std::string_view::npos;
+
+public:
+  // Offset of the token that made the last parse fail, or `npos`.
+  size_t error_offset() const noexcept { return last_error; }
+
+  std::optional<value> parse(std::string_view input) {
+    parse_table.reset();
+    last_error = std::string_view::npos;
+    lexer tokens(input);
+    try {
+      while (tokens.next([this](auto &&token) {
+        parse_table.read_token(std::move(token));
+      })) {
+      }
+      parse_table.read_token(end());
+    } catch (std::exception const &e) {
+      last_error = tokens.token_start();
+      std::cout << e.what() << " at offset " << last_error << '\n';
+      return {};
+    }
+    return std::move(parse_table.get_parse_result().root);
+  }
+};
+
+} // namespace json::tree
+
+#endif
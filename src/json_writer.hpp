@@ -0,0 +1,245 @@
+#if !defined(JSON_WRITER_HPP)
+#define JSON_WRITER_HPP
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "json_grammar.hpp"
+
+namespace json {
+
+enum class style {
+  // No whitespace at all.
+  compact,
+  // Every member and element on its own line, indented by two spaces per
+  // level.
+  pretty,
+};
+
+// Writes `json_value` trees as JSON text into a buffer that is kept across
+// calls, so a reused writer stops allocating once its buffer fits the largest
+// document. Values are dispatched on their `kind`. Numbers are written in the
+// shortest form that parses back to the same double. Non-finite numbers and
+// `json_error` placeholders are written as `null`, and members without a name
+// are left out.
+class writer {
+  static constexpr std::array<bool, 256> escaped = [] {
+    std::array<bool, 256> result{};
+    for (size_t c = 0; c < 0x20; ++c) {
+      result[c] = true;
+    }
+    result['"'] = true;
+    result['\\'] = true;
+    return result;
+  }();
+
+  // Ids below this have their quoted names cached, so a writer that sees a
+  // late interned id does not grow its cache to every id before it.
+  static constexpr uint32_t cached_keys = 4096;
+
+  std::string out;
+  // Quoted and escaped member names by interned id.
+  std::vector<std::string> keys;
+  style mode = style::compact;
+  size_t depth = 0;
+
+  // Position of the first byte at or after `from` that has to be escaped, or
+  // the size of `text`. Checks 16 bytes at a time where SSE2 is available.
+  static size_t find_escaped(std::string_view text, size_t from) {
+#if defined(__SSE2__)
+    __m128i const quote = _mm_set1_epi8('"');
+    __m128i const backslash = _mm_set1_epi8('\\');
+    __m128i const control = _mm_set1_epi8(0x1f);
+    for (; from + 16 <= text.size(); from += 16) {
+      __m128i chunk = _mm_loadu_si128(
+          reinterpret_cast<__m128i const *>(text.data() + from));
+      __m128i hits = _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                       _mm_cmpeq_epi8(chunk, backslash)),
+          _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+      if (unsigned mask = _mm_movemask_epi8(hits)) {
+        return from + std::countr_zero(mask);
+      }
+    }
+#endif
+    while (from < text.size() &&
+           !escaped[static_cast<unsigned char>(text[from])]) {
+      ++from;
+    }
+    return from;
+  }
+
+  static void escape(std::string &to, std::string_view text) {
+    size_t start = 0;
+    while (true) {
+      size_t special = find_escaped(text, start);
+      to.append(text.data() + start, special - start);
+      if (special == text.size()) {
+        return;
+      }
+      to += '\\';
+      switch (char c = text[special]) {
+      case '"':
+      case '\\':
+        to += c;
+        break;
+      case '\b':
+        to += 'b';
+        break;
+      case '\f':
+        to += 'f';
+        break;
+      case '\n':
+        to += 'n';
+        break;
+      case '\r':
+        to += 'r';
+        break;
+      case '\t':
+        to += 't';
+        break;
+      default:
+        to += "u00";
+        to += "0123456789abcdef"[(c >> 4) & 0xf];
+        to += "0123456789abcdef"[c & 0xf];
+      }
+      start = special + 1;
+    }
+  }
+
+  static void quote(std::string &to, std::string_view name) {
+    to += '"';
+    escape(to, name);
+    to += '"';
+  }
+
+  void key(uint32_t id) {
+    if (id >= cached_keys) {
+      quote(out, member_names::name(id));
+      return;
+    }
+    if (id >= keys.size()) {
+      keys.resize(id + 1);
+    }
+    std::string &quoted = keys[id];
+    if (quoted.empty()) {
+      quote(quoted, member_names::name(id));
+    }
+    out += quoted;
+  }
+
+  void separate(bool first) {
+    if (!first) {
+      out += ',';
+    }
+    if (mode == style::pretty) {
+      new_line();
+    }
+  }
+
+  void new_line() {
+    out += '\n';
+    out.append(2 * depth, ' ');
+  }
+
+  void number(double value) {
+    if (!std::isfinite(value)) {
+      out += "null";
+      return;
+    }
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+  }
+
+  void object(json_object const &object) {
+    out += '{';
+    ++depth;
+    bool first = true;
+    for (auto &member : object.members) {
+      if (!member.named()) {
+        continue;
+      }
+      separate(first);
+      first = false;
+      if (member.spilled) {
+        quote(out, *member.spilled);
+      } else {
+        key(member.key);
+      }
+      out += mode == style::pretty ? ": " : ":";
+      value(*member.value);
+    }
+    --depth;
+    if (!first && mode == style::pretty) {
+      new_line();
+    }
+    out += '}';
+  }
+
+  void list(json_list const &list) {
+    out += '[';
+    ++depth;
+    bool first = true;
+    for (auto &element : list.values) {
+      separate(first);
+      first = false;
+      value(*element);
+    }
+    --depth;
+    if (!first && mode == style::pretty) {
+      new_line();
+    }
+    out += ']';
+  }
+
+  void value(json_value const &value) {
+    switch (value.kind) {
+    case json_kind::null:
+    case json_kind::error:
+      out += "null";
+      break;
+    case json_kind::boolean:
+      out += static_cast<json_bool const &>(value).value ? "true" : "false";
+      break;
+    case json_kind::number:
+      number(static_cast<json_number const &>(value).value);
+      break;
+    case json_kind::string:
+      quote(out, static_cast<json_string const &>(value).value);
+      break;
+    case json_kind::object:
+      object(static_cast<json_object const &>(value));
+      break;
+    case json_kind::list:
+      list(static_cast<json_list const &>(value));
+      break;
+    }
+  }
+
+public:
+  // Writes `root` and returns the text, which stays valid until the next
+  // call.
+  std::string_view write(json_value const &root,
+                         style format = style::compact) {
+    out.clear();
+    mode = format;
+    depth = 0;
+    value(root);
+    return out;
+  }
+};
+
+} // namespace json
+
+#endif
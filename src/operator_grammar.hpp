@@ -0,0 +1,160 @@
+#if !defined(OPERATOR_GRAMMAR_HPP)
+#define OPERATOR_GRAMMAR_HPP
+
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "glr.hpp"
+#include "parser.hpp"
+
+// Expressions over ten binary operators of increasing precedence, once as a
+// grammar with one nonterminal per level, and once with a single nonterminal
+// and precedence declarations. Both build the same trees, and the value of
+// a tree depends on its shape, so their results can be compared. Without
+// lookahead every level of the layered grammar has a shift-reduce conflict,
+// so it is only parsed by `glr_table`, whose extra stacks die one token later.
+namespace operators {
+
+using namespace parser;
+
+constexpr size_t num_levels = 10;
+
+// Operator characters by level, from loosest to tightest.
+constexpr std::string_view operator_chars = "|^&=<>+-*/";
+
+template <size_t Level> struct op : left_assoc<Level + 1> {};
+
+struct id {
+  int value = 0;
+};
+
+struct lparen {};
+struct rparen {};
+struct end {};
+
+constexpr int combine(size_t level, int l, int r) {
+  return (l * 31 + r + static_cast<int>(level)) % 1000003;
+}
+
+// Layered grammar: `E<L> -> E<L> op<L> E<L + 1> | E<L + 1>`.
+template <size_t Level> struct E;
+
+template <> struct E<num_levels> {
+  int value = 0;
+  E(id &&i) : value(i.value) {}
+  E(lparen, E<0> &&e, rparen);
+};
+
+template <size_t Level> struct E {
+  int value = 0;
+  E(E &&l, op<Level>, E<Level + 1> &&r)
+      : value(combine(Level, l.value, r.value)) {}
+  E(E<Level + 1> &&e) : value(e.value) {}
+};
+
+inline E<num_levels>::E(lparen, E<0> &&e, rparen) : value(e.value) {}
+
+struct layered_start {
+  int value = 0;
+  layered_start(E<0> &&e, end) : value(e.value) {}
+};
+
+template <size_t... Levels>
+auto make_layered_rules(std::index_sequence<Levels...>)
+    -> set<rule<layered_start, E<0>, end>,
+           rule<E<Levels>, E<Levels>, op<Levels>, E<Levels + 1>>...,
+           rule<E<Levels>, E<Levels + 1>>..., rule<E<num_levels>, id>,
+           rule<E<num_levels>, lparen, E<0>, rparen>>;
+
+template <size_t... Levels>
+auto make_layered_nonterminals(std::index_sequence<Levels...>)
+    -> set<layered_start, E<Levels>..., E<num_levels>>;
+
+template <size_t... Levels>
+auto make_terminals(std::index_sequence<Levels...>)
+    -> set<id, lparen, rparen, end, op<Levels>...>;
+
+using levels = std::make_index_sequence<num_levels>;
+using terminals = decltype(make_terminals(levels()));
+
+using layered_table =
+    glr_table<layered_start, decltype(make_layered_rules(levels())),
+              decltype(make_layered_nonterminals(levels())), terminals>;
+
+// Precedence grammar: `P -> P op<L> P` for every level.
+struct P {
+  int value = 0;
+  P(id &&i) : value(i.value) {}
+  P(lparen, P &&p, rparen) : value(p.value) {}
+  template <size_t Level>
+  P(P &&l, op<Level>, P &&r) : value(combine(Level, l.value, r.value)) {}
+};
+
+struct precedence_start {
+  int value = 0;
+  precedence_start(P &&p, end) : value(p.value) {}
+};
+
+template <size_t... Levels>
+auto make_precedence_rules(std::index_sequence<Levels...>)
+    -> set<rule<precedence_start, P, end>, rule<P, P, op<Levels>, P>...,
+           rule<P, id>, rule<P, lparen, P, rparen>>;
+
+using precedence_table =
+    transition_table<precedence_start,
+                     decltype(make_precedence_rules(levels())),
+                     set<precedence_start, P>, terminals>;
+
+static_assert(!precedence_table::stats().has_conflict,
+              "Precedence declarations leave conflicts");
+
+// Splits the input into tokens one at a time, see `json::lexer`.
+class lexer {
+  std::string_view input;
+  size_t position = 0;
+  size_t start = 0;
+
+  template <typename Emit, size_t... Levels>
+  static void emit_op(size_t level, Emit &emit,
+                      std::index_sequence<Levels...>) {
+    ((level == Levels ? (emit(op<Levels>()), 0) : 0), ...);
+  }
+
+public:
+  lexer(std::string_view input, size_t position = 0)
+      : input(input), position(position), start(position) {}
+
+  size_t offset() const noexcept { return position; }
+
+  size_t token_start() const noexcept { return start; }
+
+  template <typename Emit> bool next(Emit &&emit) {
+    while (position < input.size()) {
+      start = position;
+      char c = input[position++];
+      if (c == ' ') {
+        continue;
+      } else if (c >= '0' && c <= '9') {
+        emit(id{c - '0'});
+      } else if (c == '(') {
+        emit(lparen());
+      } else if (c == ')') {
+        emit(rparen());
+      } else if (size_t level = operator_chars.find(c);
+                 level != std::string_view::npos) {
+        emit_op(level, emit, levels());
+      } else {
+        --position;
+        throw std::runtime_error("Invalid character");
+      }
+      return true;
+    }
+    start = position;
+    return false;
+  }
+};
+
+} // namespace operators
+
+#endif
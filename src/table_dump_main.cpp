@@ -0,0 +1,60 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "expression_grammar.hpp"
+#include "json_grammar.hpp"
+#include "table_report.hpp"
+
+using namespace parser;
+
+// The JSON tables as the grammar defines them, which `--header` writes.
+using json_tables =
+    parse_table<json::S, json::rules, json::nonterminals, json::terminals>;
+using json_recovering_tables =
+    parse_table<json::S, json::recovering_rules, json::nonterminals,
+                json::recovering_terminals>;
+
+// Prints the footprint of a grammar's table, or its automaton for `dot`.
+template <typename Table> int dump(bool graphviz) {
+  if (graphviz) {
+    write_graphviz<Table>(std::cout);
+  } else {
+    std::cout << Table::stats() << "parser bytes: " << sizeof(Table) << '\n';
+  }
+  return 0;
+}
+
+// Writes the JSON tables as the header that `json_grammar.hpp` includes.
+int write_json_header(std::string_view path) {
+  std::ofstream out{std::string(path)};
+  out << "// Generated by `table_dump json --header`: the parse tables of the "
+         "JSON\n// grammar, see `parser::precompiled`.\n"
+         "#if !defined(JSON_TABLES_HPP)\n#define JSON_TABLES_HPP\n\n"
+         "#include <array>\n#include <cstddef>\n\n#include \"parser.hpp\"\n\n"
+         "namespace json {\n\n";
+  write_tables<json_tables>(out, "tables");
+  out << '\n';
+  write_tables<json_recovering_tables>(out, "recovering_tables");
+  out << "\n} // namespace json\n\n#endif\n";
+  return out ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+  std::string_view grammar = argc > 1 ? argv[1] : "";
+  std::string_view flag = argc > 2 ? argv[2] : "";
+  bool graphviz = flag == "--dot";
+  if (grammar == "expression") {
+    return dump<expression::table>(graphviz);
+  } else if (grammar == "precedence") {
+    return dump<expression::precedence_table>(graphviz);
+  } else if (grammar == "json" && flag == "--header" && argc > 3) {
+    return write_json_header(argv[3]);
+  } else if (grammar == "json") {
+    return dump<json::table>(graphviz);
+  }
+  std::cerr << "usage: " << argv[0] << " expression|precedence|json [--dot]\n"
+            << "       " << argv[0] << " json --header path\n";
+  return 1;
+}